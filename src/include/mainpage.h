@@ -161,16 +161,177 @@ Klient:
     PN: [username]
     PASS: [password]
     DO: RUN
+    STEPS: [steps]
+    TIMEOUT: [milliseconds]
+    TOKENS: [tokens]
     XML:
     &lt;xml/&gt;
 </pre>
 
 Server:
 <pre>
+    MSG: [sprava]
     XML:
     &lt;xml/&gt;
 </pre>
 
+Polozky STEPS, TIMEOUT a TOKENS su nepovinne (aj pri krokovani) a obmedzuju
+pocet krokov, cas simulacie a pocet tokenov v sieti. Limity zadane klientom
+nemozu prekrocit limity servru (prepinace --sim-steps, --sim-time a
+--sim-tokens). Pri vycerpani limitu server zasle siet v stave, do ktoreho sa
+simulacia dostala, a polozku MSG s popisom limitu. Ak simulacia skoncila sama,
+polozka MSG sa nezasiela.
+
+Ak poziadavok STEP alebo RUN obsahuje polozku `DELTA:' (pred polozkou XML),
+server namiesto celej siete zasle len miesta, ktorych tokeny sa zmenili, a
+prechody, ktore boli uspesne:
+<pre>
+    MSG: [sprava]
+    DELTA:
+    PLACE: [placename]
+    VALUE: [tokens]
+    FIRED: [transitionname]
+</pre>
+Pre kazde zmenene miesto je PLACE a VALUE (vsetky tokeny miesta oddelene
+ciarkou) osobitne, pre kazdy uspesny prechod FIRED. Polozka MSG ma rovnaky
+vyznam ako pri odpovedi XML.
+
+* @subsection batch Suborova simulacia
+
+Poziadavok BATCH odsimuluje jednu siet z viacerych pociatocnych znackovani,
+siet sa parsuje a preklada len raz:
+<pre>
+    PN: [username]
+    PASS: [password]
+    DO: BATCH
+    NAME: [projectname]
+    VERSION: [version]
+    STEPS: [steps]
+    TIMEOUT: [milliseconds]
+    TOKENS: [tokens]
+    MARKING: [place]=[tokens];[place]=[tokens]
+    MARKING: [place]=[tokens]
+    XML:
+    &lt;xml/&gt;
+</pre>
+
+Kazda polozka MARKING je jedna simulacia (najviac 4096), zmenene miesta maju
+len zadane tokeny oddelene ciarkou, ostatne miesta maju tokeny z XML. Prazdna
+polozka `MARKING: ' simuluje siet bez zmien. Ak nie je uvedena polozka XML,
+simuluje sa dana verzia projektu. Limity plati pre kazdu simulaciu osobitne.
+Vsetky simulacie su uplne (ako RUN), siet so vsetkymi vyrazmi prelozenymi sa
+simuluje vo viacerych vlaknach naraz.
+
+Server:
+<pre>
+    BATCH:
+    COUNT: [n]
+    RESULT: [i] LIMIT [sprava]
+    RESULT: [i] ERROR [sprava]
+    PLACE: [placename]
+    VALUE: [tokens]
+</pre>
+
+RESULT je uvedeny len pre simulacie (cislovane od 1 v poradi MARKING), ktore
+vycerpali limit alebo skoncili chybou, pri chybe ostava znackovanie
+pociatocne. Vysledok je zapisany po miestach - za kazdym PLACE nasleduje n
+poloziek VALUE s tokenmi miesta v jednotlivych simulaciach.
+
+* @subsection reach Analyza dosiahnutelnosti
+
+Poziadavok REACH prehlada vsetky znackovania dosiahnutelne z pociatocneho
+znackovania siete:
+<pre>
+    PN: [username]
+    PASS: [password]
+    DO: REACH
+    NAME: [projectname]
+    VERSION: [version]
+    TIMEOUT: [milliseconds]
+    MEMORY: [MiB]
+    XML:
+    &lt;xml/&gt;
+</pre>
+
+Nasledniky znackovania su znackovania po uskutocneni jedneho prechodu
+s kazdym viazanim tokenov, pri ktorom je prechod uskutocnitelny (priority
+prechodov sa neuplatnuju), vystupne tokeny su hned aktivne. EDGES je pocet
+takychto prechodov. Znackovania s rovnakymi tokenmi v inom poradi su jeden
+stav. TIMEOUT a MEMORY
+su nepovinne a neprekrocia limity servru (`--sim-time', `--reach-memory').
+
+Server:
+<pre>
+    REACH:
+    MSG: [sprava]
+    COUNT: [states]
+    EDGES: [edges]
+    DEADLOCKS: [deadlocks]
+    PLACE: [placename]
+    BOUND: [tokens]
+    MARKING: [place]=[tokens];[place]=[tokens]
+</pre>
+
+MSG je uvedeny len pri vycerpani limitu, pocty su potom ciastocne. Za kazdym
+PLACE nasleduje najvacsi pocet tokenov miesta v najdenych stavoch. MARKING su
+prve najdene mrtve stavy (najviac 16) v zapise poziadavku BATCH.
+
+* @subsection session Simulacia otvorena na serveri
+
+Pri krokovani je mozne siet na server zaslat len raz. Klient simulaciu otvori:
+<pre>
+    PN: [username]
+    PASS: [password]
+    DO: OPEN
+    NAME: [projectname]
+    VERSION: [version]
+    XML:
+    &lt;xml/&gt;
+</pre>
+
+Polozky NAME a VERSION su nepovinne, ak nie je uvedena polozka XML, server
+otvori danu verziu projektu. Server siet prelozi a odpovie identifikatorom
+simulacie:
+<pre>
+    SESSION: [id]
+</pre>
+
+Poziadavky STEP a RUN s polozkou SESSION namiesto XML pokracuju v simulacii zo
+stavu po predchadzajucom poziadavku, odpoved je rovnaka ako pri zaslani XML.
+Poziadavok RESET vrati simulaciu do pociatocneho znackovania, CLOSE simulaciu
+zatvori. Na tieto poziadavky su zasielane standardne odpovede.
+<pre>
+    PN: [username]
+    PASS: [password]
+    DO: RESET
+    SESSION: [id]
+</pre>
+
+Simulaciu moze pouzivat len uzivatel, ktory ju otvoril. Server zatvori
+simulaciu, ktora nebola pouzita dlhsie ako --session-ttl sekund. Ak je otvorenych
+--sessions simulacii, pri otvoreni novej sa zatvori najdlhsie nepouzita.
+Klient pred krokom porovna siet so stavom po predchadzajucom kroku a pri zmene
+siete otvori novu simulaciu.
+
+Server uchovava prelozene siete projektov aj siete zaslane v poziadavkoch
+(podla SHA1 ich XML), opakovana simulacia rovnakej siete ju znovu neparsuje.
+Pamat pre siete urcuje parameter --net-cache v MiB, pri jej zaplneni sa
+odstrania najdlhsie nepouzite siete.
+
+S parametrom --pack server uklada verzie projektu namiesto adresarov verzii do
+jedneho suboru project.pack v adresari projektu, do ktoreho sa zaznamy len
+pridavaju. Verzia sa uklada ako rozdiel oproti predchadzajucej verzii
+skomprimovany pomocou zlib, kazda 16. verzia (a verzia, ktorej rozdiel nie je
+aspon o polovicu mensi ako XML) je ulozena cela. Cele verzie sa pri GET
+zasielaju priamo z namapovaneho suboru, naposledy zostavene verzie si server
+drzi v pamati.
+Verzie ulozene v adresaroch verzii server s --pack nevidi.
+
+Zaznamy o simulaciach zapisuje server vo vlakne na pozadi po davkach, najneskor
+po uplynuti intervalu danom parametrom --simlog-interval v ms (0 zapisuje kazdu
+simulaciu hned). Pred vybavenim poziadavku SIMLOG su zapisane vsetky zaradene
+zaznamy.
+
 * @subsection simlog Spristupnenie logu simulacie
 
 Klient:
@@ -192,6 +353,35 @@ Server:
 Pre kazdy zaznam v logu je time a user samostatne. Cas je udavany v Unix
 timestamp.
 
+Klient moze ziadat len cast logu nepovinnymi polozkami (vsetky nenulove):
+<pre>
+    FROM: [time]
+    TO: [time]
+    OFFSET: [n]
+    LIMIT: [n]
+    STATS:
+</pre>
+
+Zaznamy su zoradene podla casu. FROM a TO obmedzuju casovy rozsah (vratane),
+OFFSET preskoci prvych n zaznamov rozsahu a LIMIT obmedzi ich pocet. STATS
+pripoji suhrn simulacii kazdeho uzivatela za cely log. Ak poziadavok obsahuje
+niektoru z tychto poloziek, server zasle aj pocet zaznamov v casovom rozsahu:
+<pre>
+    SIMLOG:
+    TOTAL: [n]
+    TIME: [time]
+    USER: [username]
+    STATS:
+    USER: [username]
+    COUNT: [n]
+    FIRST: [time]
+    LAST: [time]
+</pre>
+
+Log simulacii verzie je na disku ulozeny binarne v simlog.bin (pri --pack v
+project.pack) a pri prvom pouziti je nacitany do pamate. Starsi textovy
+simlog.txt je pri prvom pouziti preveden do simlog.bin.
+
  * @section standard Standardne odpovede
 Standardne odpovede sa vytvaraju pomocou triedy Answer, ich mozne spravy su
 umiestnene v answer.cpp.
@@ -208,4 +398,59 @@ Vsetko prebehlo spravne:
     MSG: [SPRAVA]
 </pre>
 
+Server vybavuje spojenia pevnym poctom vlakien (prepinac --threads), spojenia
+cakajuce na volne vlakno su vo fronte (prepinac --queue). Ak je fronta plna,
+spojenie je odmietnute standardnou chybovou odpovedou s hlaskou "Server busy".
+
+ * @section keep Udrziavane spojenie
+
+Po odpovedi server spojenie ukonci. Ak poziadavok obsahuje polozku
+<pre>
+    KEEP:
+</pre>
+server po odpovedi spojenie ponecha otvorene a caka na dalsi poziadavok. Takato
+odpoved zacina rovnakou polozkou `KEEP:'. Klient moze zaslat viac poziadavkov
+za sebou bez cakania na odpovede, server ich vybavi a odpovie v poradi, v akom
+boli zaslane. Uzivatel sa overuje len pri prvom poziadavku spojenia, dalsie
+poziadavky s rovnakymi udajmi PN a PASS sa uz neoveruju. Po chybnom poziadavku
+alebo po 10 sekundach necinnosti server spojenie ukonci. Necinne udrziavane
+spojenie neobsadzuje vlakno servru, s dalsim poziadavkom sa zaradi do fronty
+spojeni mimo limitu --queue.
+
+ * @subsection frames Binarne ramce
+
+Odpoved s polozkou `KEEP:' obsahuje aj polozku
+<pre>
+    FRAMES:
+</pre>
+ktorou server oznamuje, ze prijima poziadavky v binarnych ramcoch. Ramec
+server prijme v kazdom poziadavku, aj v prvom poziadavku spojenia bez
+predchadzajucej ponuky - od textoveho poziadavku ho rozozna podla prveho
+bajtu. Klient pn2012 zasiela vsetky poziadavky v ramcoch. Ramec zacina
+8 bajtovou hlavickou, cisla su v poradi bajtov siete:
+<pre>
+    1 B   0x01 (znak ramca)
+    1 B   priznaky, zatial 0
+    2 B   dlzka poloziek
+    4 B   dlzka tela
+</pre>
+Nasleduju polozky a telo ramca. Polozka ma tvar znacka (1 B), dlzka hodnoty
+(2 B) a hodnota:
+<pre>
+    1 PN        retazec         7 STEPS     cislo (4 B)
+    2 PASS      retazec         8 TIMEOUT   cislo (4 B)
+    3 DO        retazec         9 TOKENS    cislo (4 B)
+    4 NAME      retazec        10 KEEP      bez hodnoty
+    5 DESC      retazec        11 SESSION   retazec
+    6 VERSION   cislo (4 B)    12 DELTA     bez hodnoty
+   13 FROM      cislo (4 B)    16 LIMIT     cislo (4 B)
+   14 TO        cislo (4 B)    17 STATS     bez hodnoty
+   15 OFFSET    cislo (4 B)    18 MARKING   retazec
+   19 MEMORY    cislo (4 B)
+</pre>
+Polozka MARKING sa moze v ramci opakovat.
+Retazce su bez ukoncovacieho `\r\n', hodnota DO je nazov poziadavku (napr.
+`STEP'). Telo ramca su XML data siete bez akychkolvek uprav. Telo moze mat
+najviac 64 MiB. Odpovede servru su aj pri ramcoch textove.
+
 */
@@ -11,6 +11,8 @@
 
 #include <QList>
 #include <QString>
+#include <QStringList>
+#include <QByteArray>
 #include <QTcpSocket>
 
 #include <pn/proto.h>
@@ -41,12 +43,21 @@ struct SimlogRecord {
     unsigned time;
 };
 
+/**
+ * \brief Struktura uklada zmenene miesto z odpovedi DELTA.
+ */
+struct PlaceRecord {
+    QString name;
+    QString value;
+};
+
 /**
  * Navratove hodnoty iteratorov pre spristupnenie hodnot.
  */
 typedef QList<ProjectRecord>::iterator ProjectRecord_iter;
 typedef QList<VersionRecord>::iterator VersionRecord_iter;
 typedef QList<SimlogRecord>::iterator  SimlogRecord_iter;
+typedef QList<PlaceRecord>::iterator   PlaceRecord_iter;
 
 /**
  * \brief Singleton zabezpecujucI komunikaciu so serverom - zostavovanie
@@ -68,6 +79,7 @@ class Connection {
     const QString & password() const;
     const QString & msg() const;
     const QString & xml() const;
+    const QString & session() const;
     bool connected() const;
 
     void req_clear();
@@ -83,9 +95,15 @@ class Connection {
     VersionRecord_iter req_vlist_end();
 
     unsigned req_simlog_size();
+    unsigned req_simlog_total();
     SimlogRecord_iter  req_simlog_begin();
     SimlogRecord_iter  req_simlog_end();
 
+    unsigned req_delta_size();
+    PlaceRecord_iter req_delta_begin();
+    PlaceRecord_iter req_delta_end();
+    const QStringList & fired() const;
+
     bool req_auth();
     bool req_logout();
     bool req_register();
@@ -99,7 +117,12 @@ class Connection {
     bool req_step(const QString & xml, const QString & name, unsigned version);
     bool req_run(const QString & xml);
     bool req_run(const QString & xml, const QString & name, unsigned version);
-    bool req_simlog(const QString & pname, unsigned version);
+    bool req_simlog(const QString & pname, unsigned version,
+                    unsigned offset = 0, unsigned limit = 0);
+    bool req_open(const QString & xml, const QString & name, unsigned version);
+    bool req_session_step(const QString & session, bool delta);
+    bool req_session_run(const QString & session, bool delta);
+    bool req_close(const QString & session);
 
   private:
     Connection();
@@ -116,14 +139,27 @@ class Connection {
     bool my_connected;
     unsigned my_version;
 
-    QString my_request;
+    QByteArray my_fields;   //!< Polozky ramca zostavovaneho poziadavku.
+    QByteArray my_body;     //!< Telo ramca, XML data poziadavku.
     QString my_xml;
+    QString my_session;
     QTcpSocket my_socket;
+    bool my_keep;           //!< Server ponechal spojenie otvorene.
     QList<ProjectRecord> my_list;
     QList<VersionRecord> my_vlist;
     QList<SimlogRecord> my_simlog;
-
-
+    unsigned my_simlog_total;   //!< Pocet zaznamov logu na serveri.
+    QList<PlaceRecord> my_delta;
+    QStringList my_fired;
+    unsigned my_wait;       //!< Doba cakania na odpoved poziadavku. (ms)
+
+
+    void req_type(enum Req_type type);
+    void req_field(enum Proto_field field, const QString & value);
+    void req_number(enum Proto_field field, unsigned value);
+    void req_flag(enum Proto_field field);
+    void req_sim_time();
+    QByteArray read_line();
     bool parse();
     bool send();
 }; // Connection
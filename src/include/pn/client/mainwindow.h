@@ -76,6 +76,8 @@ private slots:
     void redraw_scenes();
 
 private:
+    bool simulate(Project * project, bool run);
+
     Ui::MainWindow *ui;
     QSignalMapper *my_signal_mapper;
     Project::Mode my_current_mode;
@@ -44,6 +44,9 @@ class Project : public QGraphicsScene {
         unsigned version() const;
         bool from_server() const;
         const QString & servername() const;
+        void set_session(const QString & session, const QString & xml);
+        const QString & session() const;
+        const QString & session_xml() const;
         void remove_item(QGraphicsItem * item);
         bool set_object_name(PNObject * object, const QString name = "");
 
@@ -68,6 +71,8 @@ class Project : public QGraphicsScene {
         unsigned int my_acnt;
         unsigned int my_version; //<! Cislo verzie projektu.
         QString my_servername;   //<! Meno projektu zo serveru.
+        QString my_session;      //<! Simulacia otvorena na serveri.
+        QString my_session_xml;  //<! Siet, v ktorej stave je simulacia.
         bool my_saved; //<! Informacia, ci bol projekt ulozeny pre Save.
         bool no_duplicity(QGraphicsItem *start, QGraphicsItem *end);
         /* Funkcie pre nastavovanie nazvu objektu */
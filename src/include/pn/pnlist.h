@@ -11,6 +11,7 @@
 
 #include <QList>
 #include <QString>
+#include <QHash>
 
 // forward
 class PNObject;
@@ -37,8 +38,9 @@ class PNList {
         QString from;
         QString to;
     };
-    typedef QList<ArrowDep *> ADepList;
-    typedef QList<ArrowDep *>::iterator ADepList_iter;
+    typedef QList<ArrowDep> ADepList;
+    typedef QList<ArrowDep>::iterator ADepList_iter;
+    typedef QHash<QString, PNObject *> NameIndex;
 
     QList<PNObject *> my_list;
     QString my_error;
@@ -47,6 +49,7 @@ class PNList {
     bool parse_arrow(ADepList & alist, const QXmlStreamAttributes & attributes);
     bool parse_place(const QXmlStreamAttributes & attributes, bool server);
     bool parse_transition(const QXmlStreamAttributes & attributes);
+    bool index(NameIndex & names);
 
   public:
       PNList();
@@ -65,7 +68,7 @@ class PNList {
 
       PNList_items & items();
 
-      bool compose(ADepList & alist);
+      bool compose(ADepList & alist, const NameIndex & names);
 
       void clear();
 }; // PNList
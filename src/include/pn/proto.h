@@ -26,9 +26,51 @@ enum Req_type {
     REQ_ADD,
     REQ_STEP,
     REQ_RUN,
-    REQ_SIMLOG
+    REQ_SIMLOG,
+    REQ_OPEN,
+    REQ_RESET,
+    REQ_CLOSE,
+    REQ_BATCH,
+    REQ_REACH
 };
 
+/**
+ * \brief Znacky poloziek ramca binarneho protokolu, hodnoty su sucastou
+ * protokolu a nesmu sa menit.
+ */
+enum Proto_field {
+    FIELD_PN        = 1,
+    FIELD_PASS      = 2,
+    FIELD_DO        = 3,
+    FIELD_NAME      = 4,
+    FIELD_DESC      = 5,
+    FIELD_VERSION   = 6,
+    FIELD_STEPS     = 7,
+    FIELD_TIMEOUT   = 8,
+    FIELD_TOKENS    = 9,
+    FIELD_KEEP      = 10,
+    FIELD_SESSION   = 11,
+    FIELD_DELTA     = 12,
+    FIELD_FROM      = 13,
+    FIELD_TO        = 14,
+    FIELD_OFFSET    = 15,
+    FIELD_LIMIT     = 16,
+    FIELD_STATS     = 17,
+    FIELD_MARKING   = 18,
+    FIELD_MEMORY    = 19
+};
+
+/**
+ * \brief Znak uvodzujuci ramec binarneho protokolu. Textovy poziadavok nim
+ * nikdy nezacina.
+ */
+const char PROTO_FRAME_MAGIC = 0x01;
+/**
+ * \brief Velkost hlavicky ramca - znak, priznaky, dlzka poloziek (16 b) a dlzka
+ * tela (32 b).
+ */
+const int PROTO_FRAME_HEAD = 8;
+
 extern const char * PROTOH_PN;
 extern const char * PROTOH_DO;
 extern const char * PROTOH_PASS;
@@ -44,6 +86,33 @@ extern const char * PROTOH_XML;
 extern const char * PROTOH_SIMLOG;
 extern const char * PROTOH_MSG;
 extern const char * PROTOH_ADD;
+extern const char * PROTOH_STEPS;
+extern const char * PROTOH_TIMEOUT;
+extern const char * PROTOH_TOKENS;
+extern const char * PROTOH_KEEP;
+extern const char * PROTOH_FRAMES;
+extern const char * PROTOH_SESSION;
+extern const char * PROTOH_DELTA;
+extern const char * PROTOH_PLACE;
+extern const char * PROTOH_VALUE;
+extern const char * PROTOH_FIRED;
+extern const char * PROTOH_FROM;
+extern const char * PROTOH_TO;
+extern const char * PROTOH_OFFSET;
+extern const char * PROTOH_LIMIT;
+extern const char * PROTOH_STATS;
+extern const char * PROTOH_TOTAL;
+extern const char * PROTOH_COUNT;
+extern const char * PROTOH_FIRST;
+extern const char * PROTOH_LAST;
+extern const char * PROTOH_MARKING;
+extern const char * PROTOH_BATCH;
+extern const char * PROTOH_RESULT;
+extern const char * PROTOH_MEMORY;
+extern const char * PROTOH_REACH;
+extern const char * PROTOH_EDGES;
+extern const char * PROTOH_DEADLOCKS;
+extern const char * PROTOH_BOUND;
 
 extern const char * PROTOR_AUTH;
 extern const char * PROTOR_LOGOUT;
@@ -55,6 +124,11 @@ extern const char * PROTOR_SIMLOG;
 extern const char * PROTOR_ADD;
 extern const char * PROTOR_STEP;
 extern const char * PROTOR_RUN;
+extern const char * PROTOR_OPEN;
+extern const char * PROTOR_RESET;
+extern const char * PROTOR_CLOSE;
+extern const char * PROTOR_BATCH;
+extern const char * PROTOR_REACH;
 extern const char * PROTOR_BAD;
 extern const char * PROTOR_OK;
 
@@ -63,6 +137,12 @@ extern const char * PROTO_END;
 
 enum Req_type proto_byte2reqt(const QByteArray & byte);
 const QByteArray proto_reqt2byte(enum Req_type type);
+void proto_put_field(QByteArray & fields, enum Proto_field field,
+                     const QByteArray & value);
+void proto_put_number(QByteArray & fields, enum Proto_field field,
+                      unsigned value);
+bool proto_frame(QByteArray & frame, const QByteArray & fields,
+                 const QByteArray & body);
 
 #endif // PN_PROTO_H_
 
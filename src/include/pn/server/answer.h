@@ -9,11 +9,20 @@
 #ifndef PN_SERVER_ANSWER_H_
 #define PN_SERVER_ANSWER_H_
 
+#include <QByteArray>
+#include <QVector>
+
 #include <pn/proto.h>
 
 // forward
 class QString;
+class QIODevice;
 class ProjectDB;
+struct SimlogQuery;
+class Simulation;
+class SimNet;
+struct SimRun;
+class Reachability;
 
 /**
  * \brief Polozky MSG v standardenj odpovedi.
@@ -29,7 +38,12 @@ enum Answer_msg {
     ANSWER_BAD_REGISTER,
     ANSWER_UNKNOWN,
     ANSWER_BAD_XML,
-    ANSWER_INTERNAL_ERR
+    ANSWER_INTERNAL_ERR,
+    ANSWER_BUSY,
+    ANSWER_OK_RESET,
+    ANSWER_OK_CLOSE,
+    ANSWER_BAD_SESSION,
+    ANSWER_BAD_OPEN
 };
 
 /**
@@ -37,15 +51,21 @@ enum Answer_msg {
  */
 class Answer {
   private:
-      QString my_header;  ///< Zostaveny text odpovede.
+      QIODevice * my_out;   ///< Zariadenie (socket), do ktoreho sa odpoved zapisuje.
+      QByteArray my_header; ///< Zostavena kratka odpoved, zasiela sa az v send().
+      bool my_keep;         ///< Odpoved zacina polozkami KEEP a FRAMES.
+      bool my_sent;         ///< Odpoved uz bola (aspon sciastocne) zapisana.
+
+      void begin();
 
   public:
-    Answer();
+    Answer(QIODevice * out);
     virtual ~Answer();
 
-    const QString & text() const;
+    void send();
     void set_standard(enum Answer_msg msg);
-    void set_xml(const QString & xml);
+    void set_xml(const QByteArray & xml);
+    void set_xml(const Simulation & sim);
     void set_error(const QString & error);
     void set_add(unsigned version);
     void set_xml(ProjectDB & projects,
@@ -53,9 +73,16 @@ class Answer {
                  unsigned version);
     void set_vlist(ProjectDB & projects, const QString pname);
     void set_list(ProjectDB & projects);
+    void set_keep();
+    void set_session(const QString & session);
+    void set_delta(const Simulation & sim);
+    void set_batch(const SimNet & net, const QVector<SimRun> & runs);
+    void set_reach(const SimNet & net, const Reachability & reach);
     void set_simlog(ProjectDB & projects,
                     const QString & pname,
-                    unsigned version);
+                    unsigned version,
+                    const SimlogQuery & query,
+                    bool stats);
 
   private:
     /**
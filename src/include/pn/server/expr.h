@@ -0,0 +1,169 @@
+/**
+ * \file     expr.h
+ * \brief    Preklad podmienok a modov prechodov do jednoducheho bajtkodu.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 05 2012
+ */
+
+#ifndef PN_SERVER_EXPR_H_
+#define PN_SERVER_EXPR_H_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * \brief Prelozeny vyraz podmienky alebo modu prechodu.
+ *
+ * Podporovana je podmnozina jazyka ECMAScript - cisla, true, false, premenne,
+ * aritmeticke, relacne a logicke operatory, ternarny operator a zatvorky. Mod
+ * je postupnost priradeni oddelenych znakom ';'. Premenne su nahradene indexmi
+ * do pola hodnot (slotov): najprv vstupne sipky, potom vystupne sipky a
+ * nakoniec pomocne premenne modu. Vyrazy mimo podporovanej podmnoziny sa
+ * nepodari prelozit a je nutne ich vyhodnotit pomocou QScriptEngine.
+ *
+ * Podmienka, ktora je logickym sucinom, je rozdelena na jednotlive operandy.
+ * Operand je mozne vyhodnotit hned, ako su zname hodnoty vsetkych slotov,
+ * ktore pouziva - check(slot) vyhodnoti operandy, ktorych najvyssi pouzity
+ * slot je slot.
+ */
+class Expr {
+  public:
+    Expr();
+    ~Expr();
+
+    bool compile_condition(const QString & src, const QStringList & inputs);
+    bool compile_mode(const QString & src, const QStringList & inputs,
+                      const QStringList & outputs);
+
+    bool valid() const;
+    int slot_count() const;
+    bool assigned(int output) const;
+
+    bool condition(double * slots) const;
+    bool check(int slot, double * slots) const;
+    bool key(int slot, int & other, double & value) const;
+    void mode(double * slots) const;
+
+    static int to_token(double value);
+
+  private:
+    /**
+     * \brief Instrukcie zasobnikoveho automatu.
+     */
+    enum Op {
+        OP_CONST,       //!< Vloz konstantu value.
+        OP_LOAD,        //!< Vloz hodnotu slotu arg.
+        OP_STORE,       //!< Vyber hodnotu a uloz ju do slotu arg.
+        OP_NEG,
+        OP_NOT,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_MOD,
+        OP_EQ,
+        OP_NE,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_AND,         //!< Ak je vrchol nepravdivy skoc na arg, inak ho vyber.
+        OP_OR,          //!< Ak je vrchol pravdivy skoc na arg, inak ho vyber.
+        OP_JUMP_FALSE,  //!< Vyber hodnotu, ak je nepravdiva skoc na arg.
+        OP_JUMP         //!< Skoc na arg.
+    };
+
+    /**
+     * \brief Jedna instrukcia programu.
+     */
+    struct Instr {
+        enum Op op;
+        int arg;
+        double value;
+    };
+
+    /**
+     * \brief Lexikalne jednotky vyrazu.
+     */
+    enum Token {
+        T_END,
+        T_NUM,
+        T_IDENT,
+        T_TRUE,
+        T_FALSE,
+        T_LPAR,
+        T_RPAR,
+        T_SEMICOLON,
+        T_ASSIGN,
+        T_QUESTION,
+        T_COLON,
+        T_NOT,
+        T_PLUS,
+        T_MINUS,
+        T_MUL,
+        T_DIV,
+        T_MOD,
+        T_EQ,
+        T_NE,
+        T_LT,
+        T_LE,
+        T_GT,
+        T_GE,
+        T_AND,
+        T_OR,
+        T_ERROR
+    };
+
+    /**
+     * \brief Operand logickeho sucinu podmienky.
+     */
+    struct Conjunct {
+        int begin;      //!< Prva instrukcia operandu.
+        int end;        //!< Instrukcia za operandom.
+        int last;       //!< Najvyssi pouzity slot, -1 pre konstantu.
+        int key;        //!< Slot porovnavany v tvare key == other/value.
+        int other;      //!< Druhy slot porovnania, -1 pre konstantu.
+        double value;   //!< Konstanta porovnania.
+    };
+
+    void reset(const QString & src, const QStringList & inputs);
+    void next();
+    int emit(enum Op op, int arg = 0, double value = 0);
+    int lookup(const QString & name) const;
+
+    bool parse_expr();
+    bool parse_or();
+    bool parse_and();
+    bool parse_equality();
+    bool parse_relational();
+    bool parse_additive();
+    bool parse_multiplicative();
+    bool parse_unary();
+    bool parse_primary();
+
+    void add_conjunct(int begin);
+    double run(double * slots, int begin, int end) const;
+
+    QVector<Instr> my_code;
+    QVector<Conjunct> my_conj;  //!< Operandy podmienky podla najvyssieho slotu.
+    QVector<int> my_conj_offset; //!< Operandy so slotom s su od offsetu s + 1.
+    int my_last;                //!< Najvyssi slot pouzity v operande.
+    QStringList my_vars;        //!< Nazvy premennych podla slotov.
+    QVector<bool> my_defined;   //!< Ci je premenna v danom mieste definovana.
+    int my_inputs;
+    int my_outputs;
+    int my_depth;               //!< Aktualna hlbka zasobnika pri preklade.
+    int my_max_depth;           //!< Maximalna hlbka zasobnika programu.
+    bool my_valid;
+
+    // Stav lexikalneho analyzatora.
+    QString my_src;
+    int my_pos;
+    enum Token my_token;
+    QString my_ident;
+    double my_number;
+}; // Expr
+
+#endif // PN_SERVER_EXPR_H_
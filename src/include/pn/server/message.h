@@ -10,12 +10,15 @@
 #ifndef PN_SERVER_MESSAGE_H_
 #define PN_SERVER_MESSAGE_H_
 
+#include <QtGlobal>
+#include <QByteArray>
+#include <QStringList>
+
 #include <pn/proto.h>
 
 // forwards
 class QTcpSocket;
 class QString;
-class QByteArray;
 
 /**
  * \brief Trieda reprezentujuca rozparsovanu spravu z daneho socketu.
@@ -30,11 +33,30 @@ class Message {
     QString my_desc;
     unsigned my_version;
     unsigned my_version_stated;  // Len pre dodatocnu kontrolu v case parsovania.
-    QString my_xml;
+    QByteArray my_xml;      // Telo poziadavku (XML) tak, ako prislo.
+    unsigned my_steps;      // Limity simulacie, 0 ak neboli zadane.
+    unsigned my_timeout;
+    unsigned my_tokens;
+    bool my_keep;           // Klient ziada udrzanie spojenia.
+    QString my_session;     // Identifikator simulacie na serveri.
+    bool my_delta;          // Odpovedat len zmenami siete.
+    unsigned my_from;       // Dotaz na log simulacii, 0 ak nebol zadany.
+    unsigned my_to;
+    unsigned my_offset;
+    unsigned my_limit;
+    bool my_stats;          // Pripojit suhrn simulacii uzivatelov.
+    QStringList my_markings; // Zmeny znackovania pre kazdu simulaciu BATCH.
+    unsigned my_memory;     // Pamat analyzy REACH v MiB, 0 ak nebola zadana.
 
     QString my_error;
 
     bool parse(QTcpSocket * socket);
+    bool parse_xml(QTcpSocket * socket);
+    bool parse_frame(QTcpSocket * socket);
+    bool parse_field(int field, const QByteArray & value);
+    bool read_exact(QTcpSocket * socket, QByteArray & data, qint64 size);
+    bool parse_limit(const QByteArray & line, const char * header,
+                     unsigned & value);
     bool check();
 
   public:
@@ -47,7 +69,20 @@ class Message {
     const QString & project() const;
     unsigned version() const;
     const QString & desc() const;
-    const QString & xml() const;
+    const QByteArray & xml() const;
+    unsigned steps() const;
+    unsigned timeout() const;
+    unsigned tokens() const;
+    bool keep() const;
+    const QString & session() const;
+    bool delta() const;
+    unsigned from() const;
+    unsigned to() const;
+    unsigned offset() const;
+    unsigned limit() const;
+    bool stats() const;
+    const QStringList & markings() const;
+    unsigned memory() const;
     const QString & error() const;
 
     bool socket(QTcpSocket * socket);
@@ -0,0 +1,52 @@
+/**
+ * \file     netcache.h
+ * \brief    Vyrovnavacia pamat prelozenych sieti zdielana vlaknami servru.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 14 2012
+ */
+
+#ifndef PN_SERVER_NETCACHE_H_
+#define PN_SERVER_NETCACHE_H_
+
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+
+#include <pn/server/simnet.h>
+
+/**
+ * \brief Vyrovnavacia pamat prelozenych sieti. Siete projektov su ulozene pod
+ * klucom projekt a verzia, siete zaslane v poziadavku pod SHA1 ich XML.
+ * Velkost siete sa odhaduje podla velkosti XML, pri prekroceni kapacity su
+ * odstranene najdlhsie nepouzite siete. Siet je len na citanie, simulacie ju
+ * zdielaju a kazda ma vlastne znackovanie.
+ */
+class NetCache {
+  public:
+    NetCache(unsigned capacity);
+    ~NetCache();
+
+    SimNetPtr find(const QString & key);
+    void insert(const QString & key, const SimNetPtr & net, int size);
+
+    static QString project_key(const QString & project, unsigned version);
+    static QString xml_key(const QByteArray & xml);
+
+  private:
+    QCache<QString, SimNetPtr> my_nets;     //!< Cena polozky je v KiB.
+    QMutex my_mutex;
+
+  private:
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    NetCache(const NetCache &);
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    void operator=(const NetCache &);
+}; // NetCache
+
+#endif // PN_SERVER_NETCACHE_H_
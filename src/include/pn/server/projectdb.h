@@ -11,36 +11,136 @@
 
 #include <QStringList>
 #include <QString>
+#include <QByteArray>
 #include <QDir>
+#include <QMap>
+#include <QVector>
+#include <QReadWriteLock>
+#include <QCache>
+#include <QMutex>
+#include <QList>
+#include <QHash>
+
+// forward
+class QFile;
 
 /**
- * \brief Trieda reprezentujuca verzovaciu databazu projektov.
+ * \brief Zaznam o simulacii verzie projektu pre log simulacii.
+ */
+struct SimlogRecord {
+    unsigned time;          //!< Cas simulacie.
+    QString username;       //!< Uzivatel, ktory simuloval.
+    QString project;        //!< Nazov projektu.
+    unsigned version;       //!< Verzia projektu.
+};
+
+/**
+ * \brief Suhrn simulacii verzie projektu jednym uzivatelom.
+ */
+struct SimlogUser {
+    QString username;       //!< Uzivatel.
+    unsigned count;         //!< Pocet simulacii.
+    unsigned first;         //!< Cas prvej simulacie.
+    unsigned last;          //!< Cas poslednej simulacie.
+};
+
+/**
+ * \brief Dotaz na cast logu simulacii. Zaznamy su zoradene podla casu.
+ */
+struct SimlogQuery {
+    unsigned from;          //!< Najskorsi cas, 0 bez obmedzenia.
+    unsigned to;            //!< Najneskorsi cas, 0 bez obmedzenia.
+    unsigned offset;        //!< Pocet preskocenych zaznamov.
+    unsigned limit;         //!< Najvacsi pocet zaznamov, 0 bez obmedzenia.
+};
+
+/**
+ * \brief Trieda reprezentujuca verzovaciu databazu projektov. Projekty, ich
+ * verzie, autori, casy a popisy su pri spusteni nacitane do pamate a dotazy na
+ * ne sa vybavuju bez pristupu na disk. Verzie su ulozene bud v adresaroch
+ * (subory project.xml, desc.txt, author.txt a simlog.bin pre kazdu verziu),
+ * alebo v jednom subore project.pack pre projekt, do ktoreho sa zaznamy len
+ * pridavaju. V project.pack je kazda verzia ulozena ako plne XML alebo ako
+ * komprimovany rozdiel oproti predchadzajucej verzii.
  */
 class ProjectDB {
   private:
-    QStringList my_projects;
+    /**
+     * \brief Log simulacii verzie v pamati. Casy su zoradene vzostupne, co
+     * sluzi ako index pre dotazy na casovy rozsah. Suhrn simulacii uzivatelov
+     * sa udrzuje pri pridani kazdeho zaznamu.
+     */
+    struct Simlog {
+        bool loaded;                 //!< Log je nacitany z disku.
+        QVector<quint32> times;      //!< Casy simulacii.
+        QVector<quint32> users;      //!< Uzivatelia simulacii (index do stats).
+        QHash<QString, quint32> ids; //!< Index uzivatela podla mena.
+        QVector<SimlogUser> stats;   //!< Suhrn simulacii uzivatelov.
+    };
+
+    /**
+     * \brief Zaznam o verzii projektu v pamati.
+     */
+    struct Version {
+        QString user;       //!< Autor verzie.
+        unsigned time;      //!< Cas vytvorenia verzie.
+        QString desc;       //!< Popis verzie.
+        qint64 offset;      //!< Pozicia XML v project.pack.
+        qint64 size;        //!< Velkost XML v project.pack.
+        bool delta;         //!< XML je ulozene ako rozdiel od predch. verzie.
+        Simlog simlog;      //!< Log simulacii verzie.
+    };
+
+    QMap<QString, QVector<Version> > my_index; //!< Verzie podla projektu.
+    QReadWriteLock my_lock;                    //!< Zamok pre my_index.
     QDir my_pdir;
+    bool my_pack;           //!< Verzie su ulozene v project.pack.
     const char * my_error;
+    QCache<QString, QByteArray> my_xml_cache; //!< Zostavene XML verzii.
+    QMutex my_cache_mutex;                    //!< Zamok pre my_xml_cache.
+
+    void load();
+    void load_pack(const QString & pname, QVector<Version> & versions);
+    unsigned add_pack(const QString & pname, const QString & user,
+                      const QString & desc, const QByteArray & xml);
+    qint64 append_pack(const QString & pname, const QByteArray & record);
+    bool pack_xml(QByteArray & xml, const QString & pname, unsigned version);
+    bool cached_xml(QByteArray & xml, const QString & pname, unsigned version);
+    void cache_xml(const QByteArray & xml, const QString & pname,
+                   unsigned version);
+    bool update_pack_simlog(const QList<SimlogRecord> & records);
+    bool load_simlog(const QString & pname, unsigned version, Simlog & log);
+    bool ensure_simlog(const QString & pname, unsigned version);
+    static bool simlog_add(Simlog & log, unsigned & time,
+                           const QString & username, quint32 & id);
+    static void simlog_record(QByteArray & data, Simlog & log, unsigned time,
+                              const QString & username);
+    QString path(const QString & pname, unsigned version,
+                 const char * file) const;
+    static QString first_line(const QString & path);
 
   public:
-    ProjectDB(const QString & dir);
+    ProjectDB(const QString & dir, bool pack = false);
     virtual ~ProjectDB();
     bool exist(const QString & pname, unsigned version);
     bool exist(const QString & pname);
-    bool xml_data(QString & xml, const QString & pname, unsigned version);
+    bool xml_data(QByteArray & xml, const QString & pname, unsigned version);
+    const uchar * map_xml(QFile & file, qint64 & size, bool & delta,
+                          const QString & pname, unsigned version);
     bool desc(QString & desc, const QString & pname, unsigned version);
     bool user(QString & username, unsigned & time,
               const QString & pname, unsigned version);
-    bool simlog(QStringList & simlog, const QString & pname, unsigned & version);
+    bool simlog(QStringList & simlog, unsigned & total, const QString & pname,
+                unsigned version, const SimlogQuery & query);
+    bool simlog_users(QList<SimlogUser> & users, const QString & pname,
+                      unsigned version);
     unsigned add_project(const QString & pname,
                          const QString & user,
                          const QString & desc,
-                         const QString & xml);
+                         const QByteArray & xml);
     const QString error() const;
     bool projects(QStringList & projects);
-    bool update_simlog(const QString & username,
-                       const QString & name,
-                       unsigned version);
+    bool update_simlog(const QList<SimlogRecord> & records);
     unsigned version_count(const QString & pname);
 
   private:
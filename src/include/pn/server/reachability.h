@@ -0,0 +1,79 @@
+/**
+ * \file     reachability.h
+ * \brief    Analyza dosiahnutelnych stavov petriho siete.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 20 2012
+ */
+
+#ifndef PN_SERVER_REACHABILITY_H_
+#define PN_SERVER_REACHABILITY_H_
+
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+#include <pn/server/simnet.h>
+#include <pn/server/simulation.h>
+
+// forward
+class QScriptEngine;
+
+/**
+ * \brief Limity analyzy dosiahnutelnosti, hodnota 0 znamena bez obmedzenia.
+ */
+struct ReachBudget {
+    unsigned time;      //!< Maximalny cas analyzy v milisekundach.
+    unsigned memory;    //!< Maximalna pamat pre navstivene stavy v MiB.
+};
+
+/**
+ * \brief Prehladavanie stavoveho priestoru siete do sirky. Nasledniky stavu
+ * su znackovania po uskutocneni jedneho prechodu s kazdym viazanim tokenov
+ * (Simulation::successors()), priority prechodov sa neuplatnuju. Navstivene
+ * znackovania su ulozene v kompaktnej binarnej podobe, na poradi tokenov
+ * v mieste nezalezi.
+ */
+class Reachability {
+  public:
+    Reachability(QScriptEngine * engine);
+    ~Reachability();
+
+    bool explore(const SimNetPtr & net, const ReachBudget & budget);
+
+    unsigned states() const;
+    unsigned edges() const;
+    unsigned deadlocks() const;
+    const QVector<int> & bounds() const;
+    const QList<SimMarking> & deadlock_markings() const;
+    const QString & limit() const;
+    const QString & error() const;
+
+  private:
+    static QByteArray encode(const SimMarking & marking);
+    static SimMarking decode(const QByteArray & key, int places);
+
+    Simulation my_sim;          //!< Uskutocnovanie prechodov.
+    QElapsedTimer my_timer;
+    unsigned my_states;
+    unsigned my_edges;          //!< Pocet uskutocnenych prechodov.
+    unsigned my_deadlocks;      //!< Stavy bez uskutocnitelneho prechodu.
+    QVector<int> my_bounds;     //!< Najvacsi pocet tokenov miesta.
+    QList<SimMarking> my_deadlock_markings;  //!< Prve mrtve stavy.
+    QString my_limit;           //!< Popis vycerpaneho limitu analyzy.
+    QString my_error;
+
+  private:
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    Reachability(const Reachability &);
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    void operator=(const Reachability &);
+}; // Reachability
+
+#endif // PN_SERVER_REACHABILITY_H_
@@ -11,12 +11,55 @@
 
 #include <QTcpServer>
 #include <QSemaphore>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QElapsedTimer>
 
 #include <pn/server/projectdb.h>
 #include <pn/server/userdb.h>
+#include <pn/server/simulation.h>
+#include <pn/server/sessiondb.h>
+#include <pn/server/netcache.h>
+#include <pn/server/simlogwriter.h>
 
 // forwards
 class QTcpSocket;
+class QTimerEvent;
+class ServerThread;
+
+/**
+ * \brief Nastavenia servru z prikazoveho riadku.
+ */
+struct ServerConfig {
+    SimBudget budget;   //!< Limity simulacie.
+    unsigned threads;   //!< Pocet vlakien vybavujucich spojenia.
+    unsigned queue;     //!< Pocet spojeni, ktore mozu cakat na vlakno.
+    unsigned sessions;  //!< Maximalny pocet otvorenych simulacii.
+    unsigned session_ttl; //!< Doba necinnosti simulacie v sekundach.
+    unsigned net_cache; //!< Kapacita pamate prelozenych sieti v MiB.
+    bool pack;          //!< Verzie projektov ukladat do project.pack.
+    unsigned simlog_interval; //!< Interval zapisu logu simulacii v ms.
+    unsigned reach_memory; //!< Pamat pre stavy analyzy REACH v MiB.
+};
+
+/**
+ * \brief Spojenie cakajuce na vlakno - nove spojenie je dane deskriptorom,
+ * udrziavane spojenie ma socket a overeneho uzivatela.
+ */
+struct ServerConnection {
+    int descriptor;         //!< Deskriptor noveho spojenia.
+    QTcpSocket * socket;    //!< Socket udrziavaneho spojenia, inak 0.
+    QString username;       //!< Overeny uzivatel udrziavaneho spojenia.
+    QString password;
+    qint64 parked;          //!< Cas odlozenia necinneho spojenia v ms.
+
+    ServerConnection() : descriptor(-1), socket(0), parked(0) {}
+};
 
 /**
  * \brief Trieda reprezentujuca server.
@@ -27,20 +70,50 @@ class Server : public QTcpServer {
   private:
     // Potrebne databazy
     ProjectDB my_projects;
+    SimlogWriter my_simlog; //!< Zapis logu simulacii na pozadi.
     UserDB my_users;
-    QSemaphore my_sem_projdb, my_sem_userdb, my_sem_simlog;
+    QSemaphore my_sem_projdb, my_sem_userdb;
     // Nazov suboru, ktory sa pouzije pre ukladanie uzivatelov a ich prvotne
     // nacitanie.
     const char * my_userdb;
+    ServerConfig my_config;
+    SessionDB my_sessions;  //!< Simulacie otvorene klientmi.
+    NetCache my_nets;       //!< Prelozene siete zdielane vlaknami.
+
+    // Vlakna vybavujuce spojenia a fronta spojeni, ktore na ne cakaju.
+    QVector<ServerThread *> my_workers;
+    QQueue<int> my_connections;
+    QQueue<ServerConnection> my_resumed;    //!< Udrziavane s poziadavkom.
+    QList<ServerConnection> my_parking;     //!< Odlozene, este nesledovane.
+    QMutex my_conn_mutex;
+    QWaitCondition my_conn_cond;
+    bool my_stopping;
+    // Necinne udrziavane spojenia, sleduje ich hlavne vlakno.
+    QHash<QTcpSocket *, ServerConnection> my_parked;
+    QElapsedTimer my_clock;
+    int my_timer;           //!< Casovac ukoncenia a necinnych spojeni.
+    // Statistiky spojeni.
+    unsigned my_accepted;
+    unsigned my_rejected;
+    unsigned my_queue_peak;
+
+    void reject(int socket);
+    void requeue(QTcpSocket * socket);
+    void close_parked(QTcpSocket * socket);
+
+  private slots:
+    void watch();
+    void resume();
 
   protected:
     void incomingConnection(int socketDescriptor);
+    void timerEvent(QTimerEvent * event);
 
   public:
     Server(unsigned port, const char * userdb,
-           const char * projectdb, QObject * parent = 0);
+           const char * projectdb, const ServerConfig & config,
+           QObject * parent = 0);
     virtual ~Server();
-    bool loop();
     bool update_userdb(const QString & username, const QString & password);
     void load_userdb();
 
@@ -49,14 +122,22 @@ class Server : public QTcpServer {
     bool exist_project(const QString & pname, unsigned version = 1);
     bool add_user(const QString & username, const QString & password);
     ProjectDB & projects();
-    bool add_project(const QString & pname,
-                     const QString & username,
-                     const QString & desc,
-                     const QString & xml);
+    SessionDB & sessions();
+    NetCache & nets();
+    const SimBudget & budget() const;
+    unsigned reach_memory() const;
+    bool take_connection(ServerConnection & conn);
+    bool park(const ServerConnection & conn);
+    static void busy(QTcpSocket & socket);
+    unsigned add_project(const QString & pname,
+                         const QString & username,
+                         const QString & desc,
+                         const QByteArray & xml);
 
     bool update_simlog(const QString & username,
                        const QString & pname,
                        unsigned version);
+    void flush_simlog();
 
   private:
     /**
@@ -69,7 +150,10 @@ class Server : public QTcpServer {
     void operator=(const Server &);
 }; // Server
 
-void server2012(unsigned port, const char * userdb, const char * projectdb);
+void server2012(unsigned port, const char * userdb, const char * projectdb,
+                const ServerConfig & config);
+ServerConfig server_default_config();
+void server2012_stop();
 
 #endif // PN_SERVER_SERVER2012_H_
 
@@ -10,23 +10,41 @@
 #define PN_SERVER_SERVERTHREAD_H_
 
 #include <QThread>
+#include <QString>
 
 #include <pn/server/server2012.h>
 
+// forward
+class QScriptEngine;
+class Message;
+class Answer;
+
 /**
- * \brief Trieda pre vlakno spravujuce spojenie na servri.
+ * \brief Trieda pre vlakno spravujuce spojenia na servri. Server ma pevny pocet
+ * takychto vlakien, ktore si vyberaju spojenia z jeho fronty.
  */
 class ServerThread : public QThread {
     Q_OBJECT
 
   private:
-    int my_socket_desc;
     Server * my_server;
+    QScriptEngine * my_engine;  //!< Interpret vlakna pre simulacie.
+    QString my_username;        //!< Overeny uzivatel udrziavaneho spojenia.
+    QString my_password;
 
-    void handle_request(QTcpSocket & socket);
+    void handle_connection(ServerConnection & conn);
+    bool handle_request(QTcpSocket & socket);
+    bool authorized(const Message & msg);
+    void open_session(const Message & msg, Answer & answer);
+    void handle_session(const Message & msg, Answer & answer);
+    void run_batch(const Message & msg, Answer & answer);
+    void reach(const Message & msg, Answer & answer);
+    QScriptEngine * engine();
+    SimBudget budget(const Message & msg) const;
+    SimNetPtr net(const Message & msg);
 
   public:
-    ServerThread(int socket_desc, QObject * parent);
+    ServerThread(QObject * parent);
     virtual ~ServerThread();
 
     void run();
@@ -0,0 +1,72 @@
+/**
+ * \file     sessiondb.h
+ * \brief    Simulacie otvorene na serveri medzi poziadavkami klienta.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 12 2012
+ */
+
+#ifndef PN_SERVER_SESSIONDB_H_
+#define PN_SERVER_SESSIONDB_H_
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+// forward
+class Simulation;
+
+/**
+ * \brief Simulacia otvorena klientom poziadavkom OPEN.
+ */
+struct Session {
+    QString id;             //!< Identifikator zasielany klientovi.
+    QString username;       //!< Uzivatel, ktory simulaciu otvoril.
+    QString project;        //!< Projekt pre log simulacii, prazdny ak nie je.
+    unsigned version;       //!< Verzia projektu.
+    Simulation * sim;       //!< Prelozena siet a jej aktualne znackovanie.
+    qint64 used;            //!< Cas posledneho pouzitia (ms).
+    bool busy;              //!< Simulaciu prave vybavuje niektore vlakno.
+};
+
+/**
+ * \brief Databaza otvorenych simulacii. Simulacie, ktore neboli pouzite dlhsie
+ * ako ttl sekund, su odstranene. Pri plnej databaze je odstranena najdlhsie
+ * nepouzita simulacia. Simulaciu moze naraz vybavovat len jedno vlakno -
+ * ziska ju pomocou acquire() a vrati pomocou release().
+ */
+class SessionDB {
+  public:
+    SessionDB(unsigned capacity, unsigned ttl);
+    ~SessionDB();
+
+    QString open(const QString & username, const QString & project,
+                 unsigned version, Simulation * sim);
+    Session * acquire(const QString & id, const QString & username);
+    void release(Session * session);
+    void close(Session * session);
+
+  private:
+    void expire();
+    bool evict();
+
+    QHash<QString, Session *> my_sessions;
+    QMutex my_mutex;
+    QElapsedTimer my_clock;     //!< Cas od vytvorenia databazy.
+    unsigned my_capacity;       //!< Maximalny pocet otvorenych simulacii.
+    unsigned my_ttl;            //!< Doba necinnosti v sekundach, 0 bez limitu.
+    unsigned my_next_id;
+
+  private:
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    SessionDB(const SessionDB &);
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    void operator=(const SessionDB &);
+}; // SessionDB
+
+#endif // PN_SERVER_SESSIONDB_H_
@@ -0,0 +1,61 @@
+/**
+ * \file     simlogwriter.h
+ * \brief    Zapis logu simulacii vo vlakne na pozadi.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 16 2012
+ */
+
+#ifndef PN_SERVER_SIMLOGWRITER_H_
+#define PN_SERVER_SIMLOGWRITER_H_
+
+#include <QThread>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <pn/server/projectdb.h>
+
+/**
+ * \brief Vlakno zapisujuce log simulacii. Vlakna vybavujuce poziadavky len
+ * zaradia zaznam do fronty, vlakno ho zapise spolu s dalsimi zaznamami po
+ * uplynuti intervalu, pri naplneni davky alebo pri flush().
+ */
+class SimlogWriter : public QThread {
+    Q_OBJECT
+
+  private:
+    ProjectDB & my_projects;
+    unsigned long my_interval;  //!< Interval zapisu v ms, 0 zapisuje hned.
+    QList<SimlogRecord> my_queue;
+    quint64 my_queued;          //!< Pocet zaradenych zaznamov.
+    quint64 my_written;         //!< Pocet zapisanych zaznamov.
+    bool my_flush;              //!< Niekto caka na zapis fronty.
+    bool my_stopping;
+    QMutex my_mutex;
+    QWaitCondition my_cond;     //!< Vlakno ma zapisat frontu.
+    QWaitCondition my_done;     //!< Davka bola zapisana.
+
+  public:
+    SimlogWriter(ProjectDB & projects, unsigned interval);
+    virtual ~SimlogWriter();
+
+    void append(const QString & username, const QString & project,
+                unsigned version);
+    void flush();
+    void stop();
+    void run();
+
+  private:
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    SimlogWriter(const SimlogWriter &);
+    /**
+     * \brief DISABLE_COPY_AND_ASSIGN
+     */
+    void operator=(const SimlogWriter &);
+}; // SimlogWriter
+
+#endif // PN_SERVER_SIMLOGWRITER_H_
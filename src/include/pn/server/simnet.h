@@ -0,0 +1,166 @@
+/**
+ * \file     simnet.h
+ * \brief    Skompilovana reprezentacia petriho siete pre simulaciu na serveri.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 02 2012
+ */
+
+#ifndef PN_SERVER_SIMNET_H_
+#define PN_SERVER_SIMNET_H_
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+
+#include <pn/server/expr.h>
+#include <pn/server/tokenstore.h>
+
+// forward
+class QXmlStreamAttributes;
+class QIODevice;
+
+/**
+ * \brief Tokeny jedneho miesta pocas simulacie.
+ */
+struct SimTokens {
+    TokenStore active;      //!< Tokeny dostupne v aktualnom kroku simulacie.
+    QVector<int> passive;   //!< Tokeny pridane v aktualnom kroku simulacie.
+};
+
+/**
+ * Znackovanie siete - tokeny pre kazde miesto podla jeho indexu.
+ */
+typedef QVector<SimTokens> SimMarking;
+
+/**
+ * \brief Petriho siet bez grafickych objektov. Miesta a prechody su ulozene v
+ * poliach, sipky prechodu su ulozene v CSR formate (prechod t ma vstupne sipky
+ * in_arc(in_begin(t)) az in_arc(in_end(t) - 1)). Podobne su ulozene prechody,
+ * pre ktore je miesto vstupom (consumer()).
+ */
+class SimNet {
+  public:
+    /**
+     * \brief Miesto petriho siete.
+     */
+    struct SimPlace {
+        QString name;
+        int x;
+        int y;
+    };
+
+    /**
+     * \brief Prechod petriho siete.
+     */
+    struct SimTransition {
+        QString name;
+        QString condition;
+        QString mode;
+        int priority;
+        int x;
+        int y;
+        Expr condition_expr;    //!< Prelozena podmienka.
+        Expr mode_expr;         //!< Prelozeny mod.
+        bool compiled;          //!< Podmienka aj mod su prelozene.
+    };
+
+    /**
+     * \brief Sipka medzi prechodom a miestom.
+     */
+    struct SimArc {
+        QString name;   //!< Nazov sipky, pod ktorym je dostupna vo vyrazoch.
+        int place;      //!< Index miesta.
+    };
+
+    SimNet();
+    ~SimNet();
+
+    bool from_xml(const QByteArray & xml);
+    void xml(QIODevice * out, const SimMarking & marking) const;
+    static QString value(const SimTokens & tokens);
+    static bool parse_value(const QString & value, SimTokens & tokens);
+    bool parse_marking(const QString & changes, SimMarking & marking) const;
+    const QString & error() const;
+
+    int place_count() const;
+    int transition_count() const;
+    const SimPlace & place(int idx) const;
+    const SimTransition & transition(int idx) const;
+    int find_place(const QString & name) const;
+    bool compiled() const;
+
+    int in_begin(int trans) const;
+    int in_end(int trans) const;
+    const SimArc & in_arc(int idx) const;
+    int out_begin(int trans) const;
+    int out_end(int trans) const;
+    const SimArc & out_arc(int idx) const;
+
+    int ranked(int rank) const;
+    int rank(int trans) const;
+
+    int consumer_begin(int place) const;
+    int consumer_end(int place) const;
+    int consumer(int idx) const;
+
+    const SimMarking & initial_marking() const;
+
+    void clear();
+
+  private:
+    /**
+     * \brief Sipka tak, ako bola zapisana v XML.
+     */
+    struct SimArrow {
+        QString name;
+        QString from;
+        QString to;
+    };
+
+    /**
+     * \brief Polozka pre zachovanie poradia objektov pri zapise do XML.
+     */
+    struct SimElement {
+        enum Kind {
+            PLACE,
+            TRANSITION,
+            ARROW
+        } kind;
+        int index;
+    };
+
+    bool parse_place(const QXmlStreamAttributes & attributes);
+    bool parse_transition(const QXmlStreamAttributes & attributes);
+    bool parse_arrow(const QXmlStreamAttributes & attributes);
+    bool compose();
+    void compile(int trans);
+
+    QVector<SimPlace> my_places;
+    QVector<SimTransition> my_transitions;
+    QVector<SimArrow> my_arrows;
+    QVector<SimElement> my_order;
+
+    QVector<int> my_in_offset;      //!< CSR offsety vstupnych sipok.
+    QVector<SimArc> my_in_arcs;
+    QVector<int> my_out_offset;     //!< CSR offsety vystupnych sipok.
+    QVector<SimArc> my_out_arcs;
+
+    QVector<int> my_ranked;         //!< Prechody v poradi simulacie.
+    QVector<int> my_rank;           //!< Poradie simulacie prechodu.
+    QVector<int> my_cons_offset;    //!< CSR offsety prechodov miesta.
+    QVector<int> my_consumers;      //!< Prechody, pre ktore je miesto vstupom.
+    QHash<QString, int> my_place_index; //!< Index miesta podla nazvu.
+
+    SimMarking my_marking;          //!< Pociatocne znackovanie siete.
+    QString my_error;
+}; // SimNet
+
+/**
+ * \brief Prelozena siet zdielana simulaciami viacerych vlakien, len na citanie.
+ */
+typedef QSharedPointer<const SimNet> SimNetPtr;
+
+#endif // PN_SERVER_SIMNET_H_
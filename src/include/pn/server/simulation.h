@@ -9,25 +9,67 @@
 #ifndef PN_SERVER_SIMULATION_H_
 #define PN_SERVER_SIMULATION_H_
 
-#include <pn/pnlist.h>
 #include <QVector>
+#include <QList>
 #include <QString>
+#include <QHash>
+#include <QPair>
+#include <QScriptValue>
+#include <QScriptProgram>
+#include <QElapsedTimer>
+
+#include <pn/server/simnet.h>
 
 // forward
-class Place;
-class Transition;
+class QScriptEngine;
+
+/**
+ * \brief Limity simulacie, hodnota 0 znamena bez obmedzenia.
+ */
+struct SimBudget {
+    unsigned steps;     //!< Maximalny pocet krokov pri odsimulovani.
+    unsigned time;      //!< Maximalny cas simulacie v milisekundach.
+    unsigned tokens;    //!< Maximalny pocet tokenov v sieti.
+};
+
+/**
+ * \brief Jedna simulacia suboru simulacii jednej siete (Simulation::batch_run).
+ */
+struct SimRun {
+    SimMarking marking;     //!< Pociatocne, po simulacii vysledne znackovanie.
+    QString limit;          //!< Popis vycerpaneho limitu simulacie.
+    QString error;          //!< Chyba simulacie, znackovanie sa nezmeni.
+};
 
 /**
  * \brief Trieda pre simulaciu petriho sieti.
  */
 class Simulation {
   public:
-    Simulation();
+    Simulation(QScriptEngine * engine);
     ~Simulation();
-    bool prepare(const QString & xml);
-    bool run(QString & result);
-    bool step(QString & result);
+    void prepare(const SimNetPtr & net);
+    void reset();
+    void set_marking(const SimMarking & marking);
+    bool run();
+    bool step();
+    bool successors(const SimMarking & marking, int trans,
+                    QList<SimMarking> & next);
+    const SimNet & net() const;
+    const SimMarking & marking() const;
+    const QVector<int> & changed() const;
+    const QVector<int> & fired() const;
     const QString & error() const;
+    const QString & limit() const;
+    void set_budget(const SimBudget & budget);
+    void set_engine(QScriptEngine * engine);
+    void release_scripts();
+    void set_parallel(bool parallel);
+
+    static SimBudget default_budget();
+    static SimBudget budget(const SimBudget & server, const SimBudget & request);
+    static void batch_run(const SimNetPtr & net, const SimBudget & budget,
+                          QVector<SimRun> & runs, QScriptEngine * engine);
 
   private:
     /**
@@ -42,23 +84,104 @@ class Simulation {
      * \brief Struktura pre uchovanie informacii o mieste pri simulacii.
      */
     struct SimPart {
-        Place * place;
+        int place;
         QString name;
         int index;
     };
 
-    bool simulate(QString & result, enum SimType type);
-    bool transition_sim(Transition * t);
+    /**
+     * \brief Stav simulacie jedneho prechodu. Prechody davky sa simuluju
+     * naraz vo vlaknach, kazdy s vlastnym stavom. Vo vlakne sa znackovanie
+     * len cita, tokeny prechodu presunie az consume() v hlavnom vlakne.
+     */
+    struct SimFiring {
+        Simulation * sim;
+        int trans;              //!< Prave simulovany prechod.
+        QVector<SimPart> from;  //!< Vstupne miesta a viazane tokeny.
+        QVector<SimPart> to;    //!< Vystupne miesta.
+        QVector<double> slots;  //!< Sloty prelozenych vyrazov.
+        QVector<QHash<int, QVector<int> > > index; //!< Tokeny podla hodnoty.
+        QVector<bool> indexed;  //!< Index pre vstupnu sipku je vytvoreny.
+        unsigned probes;        //!< Pocet skusanych tokenov pri viazani.
+        unsigned produced;      //!< Pocet pridanych pasivnych tokenov.
+        QVector<QPair<int, int> > output; //!< Miesto a hodnota tokenov vlakna.
+        QList<SimMarking> * successors; //!< Znackovania vsetkych viazani, inak 0.
+        bool parallel;          //!< Prechod sa simuluje mimo hlavneho vlakna.
+        bool timeout;           //!< Pri simulacii vo vlakne uplynul cas.
+        bool fired;             //!< Prechod davky bol uskutocneny.
+    };
 
-    bool transition_sim_step(int & idx, QVector<SimPart*> * places, bool first);
-    bool transition_sim_inc(int idx, QVector<SimPart *> * places);
+    bool simulate(enum SimType type);
+    void diff();
+    bool sequential(int trans, bool & fired);
+    bool transition_sim(SimFiring & f, int trans);
+    static void batch_sim(SimFiring & f);
+    int collect();
+    bool batch(int count);
 
-    bool init_places(Transition * trans, QVector<SimPart*> * places_to,
-                                 QVector<SimPart*> * places_from);
-    void delete_places(QVector<SimPart*> * places);
+    void init_places(SimFiring & f, int trans);
+    bool bind(SimFiring & f, int level);
+    bool used(const SimFiring & f, int level, int index) const;
+    bool fire(SimFiring & f);
+    bool expired(SimFiring & f);
+
+    void produce(SimFiring & f, int place, int token);
+    void consume(const SimFiring & f);
+    void successor(SimFiring & f);
+    static void take_bound(const SimFiring & f, SimMarking & marking);
+    void commit(const SimFiring & f);
+    void touch(int place);
+    void record(int place);
+    void mark(int trans);
+    bool exhausted();
 
     QString my_error;
-    PNList my_list;
+    QString my_limit;           //!< Popis vycerpaneho limitu simulacie.
+    SimBudget my_budget;
+    QElapsedTimer my_timer;     //!< Cas od zaciatku simulacie.
+    unsigned my_token_count;    //!< Pocet tokenov v sieti.
+    QScriptEngine * my_engine;  //!< Interpret pre neprelozene vyrazy.
+    SimNetPtr my_net;           //!< Prelozena siet, moze byt zdielana.
+    SimMarking my_marking;      //!< Vlastne znackovanie, kopia pri zapise.
+    QVector<QScriptProgram> my_conditions;  //!< Neprelozene podmienky.
+    QVector<QScriptProgram> my_modes;       //!< Neprelozene mody.
+
+    // Prechod simulovany v hlavnom vlakne.
+    SimFiring my_firing;
+    QScriptValue my_scope;      //!< Globalny objekt pre neprelozene vyrazy.
+
+    // Davka nezavislych prelozenych prechodov simulovanych naraz. Miesta
+    // prechodu t su my_conflicts[my_conflict_begin[t]] az
+    // my_conflicts[my_conflict_begin[t + 1] - 1].
+    QVector<SimFiring> my_batch;
+    QVector<int> my_conflict_begin;
+    QVector<int> my_conflicts;
+    QVector<unsigned> my_batch_place;   //!< Davka, ktora miesto pouziva.
+    unsigned my_batch_id;
+    int my_batch_max;           //!< Velkost davky, 0 bez simulacie vo vlaknach.
+
+    // Prechody, ktore je potrebne simulovat. Prechod, ktory nebol uspesny a
+    // do jeho vstupnych miest odvtedy neboli pridane tokeny, by nebol uspesny
+    // ani znova - odobratim tokenov moznosti viazania len ubudaju.
+    QVector<int> my_queue;      //!< Halda poradi prechodov aktualneho kroku.
+    QVector<int> my_pending;    //!< Prechody pre nasledujuci krok.
+    QVector<unsigned> my_marked;    //!< Krok, v ktorom bol prechod zaradeny.
+    unsigned my_epoch;          //!< Poradove cislo kroku simulacie.
+
+    // Miesta s pasivnymi tokenmi, ktore sa na konci kroku presunu medzi
+    // aktivne. Ostatne miesta sa pri prechode do dalsieho kroku neprechadzaju.
+    QVector<int> my_filled;
+    QVector<unsigned> my_filled_epoch;  //!< Krok, v ktorom bolo miesto pridane.
+
+    // Zmeny posledneho poziadavku na simulaciu. Zaznamy miest a prechodov
+    // platia len pre aktualnu generaciu (volanie simulate()).
+    unsigned my_generation;
+    SimMarking my_before;       //!< Znackovanie pred simulaciou.
+    QVector<int> my_touched;    //!< Miesta uspesnych prechodov.
+    QVector<unsigned> my_touched_gen;
+    QVector<int> my_changed;    //!< Miesta so zmenenymi tokenmi.
+    QVector<int> my_fired;      //!< Uspesne prechody v poradi simulacie.
+    QVector<unsigned> my_fired_gen;
 
   private:
     /**
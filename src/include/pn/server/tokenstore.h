@@ -0,0 +1,52 @@
+/**
+ * \file     tokenstore.h
+ * \brief    Ulozenie aktivnych tokenov miesta pocas simulacie.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 18 2012
+ */
+
+#ifndef PN_SERVER_TOKENSTORE_H_
+#define PN_SERVER_TOKENSTORE_H_
+
+#include <QVector>
+#include <QHash>
+
+/**
+ * \brief Multimnozina tokenov miesta. Tokeny su pristupne cez sloty - pri
+ * malom pocte opakovani je slot jeden token (pole, odobratie presunie posledny
+ * token na miesto odobrateho), pri mnohych rovnakych tokenoch je slot hodnota
+ * s poctom jej tokenov. Sposob ulozenia sa voli automaticky podla pomeru
+ * roznych hodnot a tokenov. Pridanie aj odobratie tokenu je O(1), poradie
+ * slotov sa pri odobrati meni.
+ */
+class TokenStore {
+  public:
+    TokenStore();
+
+    int size() const;
+    bool empty() const;
+    int slot_count() const;
+    int value(int slot) const;
+    int count(int slot) const;
+    bool counted() const;
+    int find(int value) const;
+    QVector<int> values() const;
+
+    void add(int value);
+    void add(const QVector<int> & tokens);
+    void take(int slot);
+
+  private:
+    void count_tokens();
+    void spread_tokens();
+
+    QVector<int> my_values;     //!< Tokeny, pri pocitani rozne hodnoty.
+    QVector<int> my_counts;     //!< Pocty tokenov hodnot pri pocitani.
+    QHash<int, int> my_slots;   //!< Slot hodnoty pri pocitani.
+    int my_size;                //!< Pocet tokenov.
+    int my_check;               //!< Pocet tokenov pre dalsiu volbu ulozenia.
+    bool my_counted;            //!< Tokeny su ulozene ako hodnoty s poctom.
+}; // TokenStore
+
+#endif // PN_SERVER_TOKENSTORE_H_
@@ -17,6 +17,11 @@
 
 const unsigned CONNECTION_TIMEOUT  = 5000;  //!< Doba cakania na spojenie. (ms)
 const unsigned CONNECTION_BUFSIZE  =   512;   //!< Velkost bufferu pre odpoved.
+/**
+ * Limit casu simulacie zasielany v poziadavku (polozka TIMEOUT). Na odpoved
+ * poziadavku so simulaciou sa caka este CONNECTION_TIMEOUT navyse. (ms)
+ */
+const unsigned CONNECTION_SIM_TIME = 10000;
 
 /**
  * Inicializacia singletonu.
@@ -29,6 +34,9 @@ Connection * Connection::my_instance = 0;
 Connection::Connection() {
     my_error = false;
     my_connected = false;
+    my_keep = false;
+    my_simlog_total = 0;
+    my_wait = CONNECTION_TIMEOUT;
 }
 
 /**
@@ -166,6 +174,15 @@ const QString & Connection::xml() const {
     return my_xml;
 }
 
+/**
+ * \brief Identifikator simulacie otvorenej na serveri poziadavkom
+ * Connection::req_open().
+ * \return Identifikator simulacie.
+ */
+const QString & Connection::session() const {
+    return my_session;
+}
+
 /**
  * \brief Zmaze stavove informacie ukladane zo zasielania poziadavku a
  * spracovania odpovedi.
@@ -173,12 +190,72 @@ const QString & Connection::xml() const {
  */
 void Connection::req_clear() {
     my_xml.clear();
+    my_session.clear();
     my_msg.clear();
-    my_request.clear();
+    my_fields.clear();
+    my_body.clear();
     my_list.clear();
     my_vlist.clear();
     my_simlog.clear();
+    my_simlog_total = 0;
+    my_delta.clear();
+    my_fired.clear();
     my_error = false;
+    my_wait = CONNECTION_TIMEOUT;
+}
+
+/**
+ * \brief Pripojenie typu poziadavku. Kazdy poziadavok ziada aj udrzanie
+ * spojenia (polozka KEEP).
+ * \param type Typ poziadavku.
+ * \retval void
+ */
+void Connection::req_type(enum Req_type type) {
+    QByteArray value = proto_reqt2byte(type);
+
+    value.chop(qstrlen(PROTO_EOL));
+    proto_put_field(my_fields, FIELD_DO, value);
+    proto_put_field(my_fields, FIELD_KEEP, QByteArray());
+}
+
+/**
+ * \brief Pripojenie retazcovej polozky poziadavku.
+ * \param field Znacka polozky.
+ * \param value Hodnota polozky.
+ * \retval void
+ */
+void Connection::req_field(enum Proto_field field, const QString & value) {
+    proto_put_field(my_fields, field, value.toAscii());
+}
+
+/**
+ * \brief Pripojenie ciselnej polozky poziadavku.
+ * \param field Znacka polozky.
+ * \param value Hodnota polozky.
+ * \retval void
+ */
+void Connection::req_number(enum Proto_field field, unsigned value) {
+    proto_put_number(my_fields, field, value);
+}
+
+/**
+ * \brief Pripojenie polozky poziadavku bez hodnoty.
+ * \param field Znacka polozky.
+ * \retval void
+ */
+void Connection::req_flag(enum Proto_field field) {
+    proto_put_field(my_fields, field, QByteArray());
+}
+
+/**
+ * \brief Pripojenie limitu casu simulacie k poziadavku. Server simulaciu
+ * ukonci najneskor po CONNECTION_SIM_TIME, preto na odpoved klient caka
+ * dlhsie ako pri ostatnych poziadavkoch.
+ * \retval void
+ */
+void Connection::req_sim_time() {
+    this->req_number(FIELD_TIMEOUT, CONNECTION_SIM_TIME);
+    my_wait = CONNECTION_TIMEOUT + CONNECTION_SIM_TIME;
 }
 
 /**
@@ -189,7 +266,8 @@ void Connection::req_clear() {
 void Connection::all_clear() {
     this->req_clear();
 
-    my_socket.deleteLater();
+    my_socket.abort();
+    my_keep = false;
     my_host.clear();
     my_username.clear();
 }
@@ -205,12 +283,9 @@ bool Connection::req_auth() {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
     my_connected = true;
 
-    my_request = PROTOH_PN;
-
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_AUTH);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_type(REQ_AUTH);
+    this->req_field(FIELD_PASS, my_password);
 
     rv = this->send();
 
@@ -226,12 +301,10 @@ bool Connection::req_auth() {
  */
 bool Connection::req_logout() {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_LOGOUT);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_LOGOUT);
 
     return this->send();
 }
@@ -243,13 +316,11 @@ bool Connection::req_logout() {
  */
 bool Connection::req_register() {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
     my_connected = true; // nastavuje sa prve spojenie (prevencia pred chybou)
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_REGISTER);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_type(REQ_REGISTER);
+    this->req_field(FIELD_PASS, my_password);
 
     return this->send();
 }
@@ -261,12 +332,10 @@ bool Connection::req_register() {
  */
 bool Connection::req_list() {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_LIST);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_LIST);
 
     return this->send();
 }
@@ -278,13 +347,11 @@ bool Connection::req_list() {
  */
 bool Connection::req_vlist(QString & pname) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_VLIST);
-    my_request.append(PROTOH_NAME).append(pname).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_VLIST);
+    this->req_field(FIELD_NAME, pname);
 
     return this->send();
 }
@@ -347,6 +414,15 @@ unsigned Connection::req_simlog_size() {
     return my_simlog.size();
 }
 
+/**
+ * \brief Metoda pre spristupnenie celkoveho poctu zaznamov v simlogu na
+ * serveri, ak bola ziadana len cast logu.
+ * \return pocet zaznamov v simlogu na serveri
+ */
+unsigned Connection::req_simlog_total() {
+    return my_simlog_total;
+}
+
 /**
  * \brief Metoda pre spristupnenie informacii z logov.
  * \retval Iterator pre zaznamy z logov.
@@ -363,6 +439,39 @@ SimlogRecord_iter Connection::req_simlog_end() {
     return my_simlog.end();
 }
 
+/**
+ * \brief Metoda pre spristupnenie poctu zmenenych miest v odpovedi DELTA.
+ * \return pocet zmenenych miest
+ */
+unsigned Connection::req_delta_size() {
+    return my_delta.size();
+}
+
+/**
+ * \brief Metoda pre spristupnenie zmenenych miest z odpovedi DELTA.
+ * \retval Iterator pre zmenene miesta.
+ */
+PlaceRecord_iter Connection::req_delta_begin() {
+    return my_delta.begin();
+}
+
+/**
+ * \brief Metoda pre spristupnenie konca zmenenych miest.
+ * \retval Koncovy iterator pre zmenene miesta.
+ */
+PlaceRecord_iter Connection::req_delta_end() {
+    return my_delta.end();
+}
+
+/**
+ * \brief Spristupnenie prechodov, ktore boli uspesne pri simulacii s odpovedou
+ * DELTA.
+ * \return Nazvy prechodov.
+ */
+const QStringList & Connection::fired() const {
+    return my_fired;
+}
+
 /**
  * \brief Zasle poziadavok pre spristupnenie konkretnej verzie daneho projektu.
  * \param name Nazov projektu, ktory ma byt spristupneny.
@@ -372,14 +481,12 @@ SimlogRecord_iter Connection::req_simlog_end() {
  */
 bool Connection::req_get(const QString & name, unsigned version) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_GET);
-    my_request.append(PROTOH_NAME).append(name).append(PROTO_EOL);
-    my_request.append(PROTOH_VERSION).append(QString::number(version)).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_GET);
+    this->req_field(FIELD_NAME, name);
+    this->req_number(FIELD_VERSION, version);
 
     return this->send();
 }
@@ -396,15 +503,13 @@ bool Connection::req_add(const QString & name,
                          const QString & desc,
                          const QString & xml) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_ADD);
-    my_request.append(PROTOH_NAME).append(name).append(PROTO_EOL);
-    my_request.append(PROTOH_DESC).append(desc).append(PROTO_EOL);
-    my_request.append(PROTOH_XML).append(xml).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_ADD);
+    this->req_field(FIELD_NAME, name);
+    this->req_field(FIELD_DESC, desc);
+    my_body = xml.toAscii();
 
     return this->send();
 }
@@ -417,13 +522,12 @@ bool Connection::req_add(const QString & name,
  */
 bool Connection::req_step(const QString & xml) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_STEP);
-    my_request.append(PROTOH_XML).append(xml).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_STEP);
+    this->req_sim_time();
+    my_body = xml.toAscii();
 
     return this->send();
 }
@@ -440,21 +544,19 @@ bool Connection::req_step(const QString & xml,
                           const QString & name,
                           unsigned version) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_STEP);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_STEP);
+    this->req_sim_time();
 
     // Pokial je projekt zo serveru.
     if (! name.isEmpty() && version != 0) {
-        my_request.append(PROTOH_NAME).append(name).append(PROTO_EOL);
-        my_request.append(PROTOH_VERSION).append(QString::number(version))
-                  .append(PROTO_EOL);
+        this->req_field(FIELD_NAME, name);
+        this->req_number(FIELD_VERSION, version);
     }
 
-    my_request.append(PROTOH_XML).append(xml).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    my_body = xml.toAscii();
 
     return this->send();
 }
@@ -467,13 +569,12 @@ bool Connection::req_step(const QString & xml,
  */
 bool Connection::req_run(const QString & xml) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_RUN);
-    my_request.append(PROTOH_XML).append(xml).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_RUN);
+    this->req_sim_time();
+    my_body = xml.toAscii();
 
     return this->send();
 }
@@ -490,21 +591,19 @@ bool Connection::req_run(const QString & xml,
                          const QString & name,
                          unsigned version) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_RUN);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_RUN);
+    this->req_sim_time();
 
     // Pokial je projekt zo serveru.
     if (! name.isEmpty() && version != 0) {
-        my_request.append(PROTOH_NAME).append(name).append(PROTO_EOL);
-        my_request.append(PROTOH_VERSION).append(QString::number(version))
-                  .append(PROTO_EOL);
+        this->req_field(FIELD_NAME, name);
+        this->req_number(FIELD_VERSION, version);
     }
 
-    my_request.append(PROTOH_XML).append(xml).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    my_body = xml.toAscii();
 
     return this->send();
 }
@@ -513,19 +612,113 @@ bool Connection::req_run(const QString & xml,
  * \brief Zaslanie poziadavku pre ziskanie zaznamu z logovacieho suboru simulacii
  * \param pname Nazov projektu pre spristupnenie logu
  * \param version Konkretna verzia projektu pre spristupnenie logu
+ * \param offset Pocet preskocenych najstarsich zaznamov.
+ * \param limit Najvacsi pocet zaznamov, 0 bez obmedzenia.
+ * \return Informacia o spravnom prevedeni poziadavku.
+ * \retval false v pripade chyby.
+ */
+bool Connection::req_simlog(const QString & pname, unsigned version,
+                            unsigned offset, unsigned limit) {
+    this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
+
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_SIMLOG);
+    this->req_field(FIELD_NAME, pname);
+    this->req_number(FIELD_VERSION, version);
+    if (offset)
+        this->req_number(FIELD_OFFSET, offset);
+    if (limit)
+        this->req_number(FIELD_LIMIT, limit);
+
+    return this->send();
+}
+
+/**
+ * \brief Otvorenie simulacie na serveri. Server si siet ponecha a dalsie kroky
+ * simulacie sa zasielaju bez XML. Identifikator simulacie je mozne spristupnit
+ * pomocou Connection::session().
+ * \param xml XML format projektu pre simulovanie.
+ * \param name Meno projektu na serveri, prazdne ak projekt nie je zo serveru.
+ * \param version Cislo verzie projektu.
+ * \return Informacia o spravnom prevedeni poziadavku.
+ * \retval false v pripade chyby.
+ */
+bool Connection::req_open(const QString & xml,
+                          const QString & name,
+                          unsigned version) {
+    this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
+
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_OPEN);
+
+    // Pokial je projekt zo serveru.
+    if (! name.isEmpty() && version != 0) {
+        this->req_field(FIELD_NAME, name);
+        this->req_number(FIELD_VERSION, version);
+    }
+
+    my_body = xml.toAscii();
+
+    return this->send();
+}
+
+/**
+ * \brief Prevedenie kroku simulacie otvorenej na serveri.
+ * \param session Identifikator simulacie.
+ * \param delta Ziadat len zmeny siete namiesto celej siete v XML.
+ * \return Informacia o spravnom prevedeni poziadavku.
+ * \retval false v pripade chyby.
+ */
+bool Connection::req_session_step(const QString & session, bool delta) {
+    this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
+
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_STEP);
+    this->req_sim_time();
+    this->req_field(FIELD_SESSION, session);
+    if (delta)
+        this->req_flag(FIELD_DELTA);
+
+    return this->send();
+}
+
+/**
+ * \brief Odsimulovanie simulacie otvorenej na serveri.
+ * \param session Identifikator simulacie.
+ * \param delta Ziadat len zmeny siete namiesto celej siete v XML.
+ * \return Informacia o spravnom prevedeni poziadavku.
+ * \retval false v pripade chyby.
+ */
+bool Connection::req_session_run(const QString & session, bool delta) {
+    this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
+
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_RUN);
+    this->req_sim_time();
+    this->req_field(FIELD_SESSION, session);
+    if (delta)
+        this->req_flag(FIELD_DELTA);
+
+    return this->send();
+}
+
+/**
+ * \brief Zatvorenie simulacie otvorenej na serveri.
+ * \param session Identifikator simulacie.
  * \return Informacia o spravnom prevedeni poziadavku.
  * \retval false v pripade chyby.
  */
-bool Connection::req_simlog(const QString & pname, unsigned version) {
+bool Connection::req_close(const QString & session) {
     this->req_clear(); // Odstrani pozostatky predchadzajuceho poziadavku.
-    my_request = PROTOH_PN;
 
-    my_request.append(my_username).append(PROTO_EOL);
-    my_request.append(PROTOH_PASS).append(my_password).append(PROTO_EOL);
-    my_request.append(PROTOH_DO).append(PROTOR_SIMLOG);
-    my_request.append(PROTOH_NAME).append(pname).append(PROTO_EOL);
-    my_request.append(PROTOH_VERSION).append(QString::number(version)).append(PROTO_EOL);
-    my_request.append(PROTO_END);
+    this->req_field(FIELD_PN, my_username);
+    this->req_field(FIELD_PASS, my_password);
+    this->req_type(REQ_CLOSE);
+    this->req_field(FIELD_SESSION, session);
 
     return this->send();
 }
@@ -539,26 +732,78 @@ bool Connection::parse() {
     QByteArray line;
     bool parsed = false; // informacia o spracovani poziadavku (return)
 
+    my_keep = false;
     for (;;) {
-        line = my_socket.readLine();
+        line = this->read_line();
 
-        if (! qstrcmp(line.data(), PROTO_END)) {
+        if (line.isEmpty() || ! qstrcmp(line.data(), PROTO_END)) {
             break;
+        } else if (! qstrcmp(line.data(), PROTOH_KEEP)) {
+            my_keep = true;
+        } else if (! qstrcmp(line.data(), PROTOH_FRAMES)) {
+            // Ramce sa zasielaju vzdy, ponuka servru sa len preskoci.
+            continue;
+        } else if (! qstrncmp(line.data(), PROTOH_MSG, qstrlen(PROTOH_MSG))) {
+            // Sprava k odpovedi, napr. ciastocny vysledok simulacie.
+            my_msg = line.mid(qstrlen(PROTOH_MSG));
+            my_msg.resize(qstrlen(my_msg.toAscii()) - 2);// Odstrani \r\n
+        } else if (! qstrncmp(line.data(), PROTOH_SESSION,
+                              qstrlen(PROTOH_SESSION))) {
+            my_session = line.mid(qstrlen(PROTOH_SESSION));
+            my_session.chop(2); // Odstrani \r\n
+            parsed = true;
         } else if (! qstrcmp(line.data(), PROTOH_XML)) {
-            line = my_socket.readLine();
-            while ((my_xml.mid(my_xml.length() - 2) != "\n\n"
-                    && my_xml.mid(my_xml.length() - 4) != "\r\n\r\n")
-                    && my_socket.isReadable()) {
+            // Cita sa presne po koniec odpovede, za nou moze nasledovat
+            // odpoved na dalsi poziadavok.
+            line = this->read_line();
+            while (! line.isEmpty()) {
                 my_xml.append(line);
-                line = my_socket.readLine();
+                if (my_xml.endsWith("\n\n") || my_xml.endsWith("\r\n\r\n"))
+                    break;
+                line = this->read_line();
             }
+            parsed = ! line.isEmpty();
+            break;
+
+        } else if (! qstrcmp(line.data(), PROTOH_DELTA)) {
+            PlaceRecord place;
+
+            line = this->read_line();
+            while (qstrcmp(line.data(), PROTO_END)) {
+                if (! qstrncmp(line.data(), PROTOH_PLACE,
+                               qstrlen(PROTOH_PLACE))) {
+                    place.name = line.mid(qstrlen(PROTOH_PLACE));
+                    place.name.chop(2); // Odstrani \r\n
+
+                    line = this->read_line();
+                    if (qstrncmp(line.data(), PROTOH_VALUE,
+                                 qstrlen(PROTOH_VALUE))) {
+                        my_msg = QObject::tr("Malformed answer");
+                        my_error = true;
+                        return false;
+                    }
+                    place.value = line.mid(qstrlen(PROTOH_VALUE));
+                    place.value.chop(2);
+                    my_delta.push_back(place);
+                } else if (! qstrncmp(line.data(), PROTOH_FIRED,
+                                      qstrlen(PROTOH_FIRED))) {
+                    line.chop(2);
+                    my_fired.push_back(line.mid(qstrlen(PROTOH_FIRED)));
+                } else {
+                    my_msg = QObject::tr("Malformed answer");
+                    my_error = true;
+                    return false;
+                }
+                line = this->read_line();
+            }
+
             parsed = true;
             break;
 
         } else if (! qstrcmp(line.data(), PROTOH_LIST)) {
             ProjectRecord proj;
 
-            line = my_socket.readLine();
+            line = this->read_line();
             while (qstrcmp(line.data(), PROTO_END)) {
                 if (! qstrncmp(line.data(), PROTOH_NAME, qstrlen(PROTOH_NAME))) {
                     proj.name = line.mid(qstrlen(PROTOH_NAME));
@@ -569,7 +814,7 @@ bool Connection::parse() {
                     return false;
                 }
                 my_list.push_back(proj);
-                line = my_socket.readLine();
+                line = this->read_line();
             }
 
             parsed = true;
@@ -578,7 +823,7 @@ bool Connection::parse() {
         } else if (! qstrcmp(line.data(), PROTOH_VLIST)) {
             VersionRecord ver;
 
-            line = my_socket.readLine();
+            line = this->read_line();
             while (qstrcmp(line.data(), PROTO_END)) {
                 if (! qstrncmp(line.data(), PROTOH_DESC, qstrlen(PROTOH_DESC))) {
                     ver.desc = line.mid(qstrlen(PROTOH_DESC));
@@ -589,7 +834,7 @@ bool Connection::parse() {
                     return false;
                 }
 
-                line = my_socket.readLine();
+                line = this->read_line();
 
                 if (! qstrncmp(line.data(), PROTOH_USER, qstrlen(PROTOH_USER))) {
                     ver.user =  line.mid(qstrlen(PROTOH_USER));
@@ -600,7 +845,7 @@ bool Connection::parse() {
                     return false;
                 }
 
-                line = my_socket.readLine();
+                line = this->read_line();
 
                 if (! qstrncmp(line.data(), PROTOH_TIME, qstrlen(PROTOH_TIME))) {
                     line.chop(2);
@@ -612,7 +857,7 @@ bool Connection::parse() {
                 }
 
                 my_vlist.push_front(ver);
-                line = my_socket.readLine();
+                line = this->read_line();
             }
 
             parsed = true;
@@ -621,7 +866,14 @@ bool Connection::parse() {
         } else if (! qstrcmp(line.data(), PROTOH_SIMLOG)) {
             SimlogRecord log;
 
-            line = my_socket.readLine();
+            line = this->read_line();
+            if (! qstrncmp(line.data(), PROTOH_TOTAL, qstrlen(PROTOH_TOTAL))) {
+                line = line.mid(qstrlen(PROTOH_TOTAL));
+                line.resize(qstrlen(line) - 2);
+                my_simlog_total = line.toUInt();
+                line = this->read_line();
+            }
+
             while (qstrcmp(line.data(), PROTO_END)) {
                 if (! qstrncmp(line.data(), PROTOH_TIME, qstrlen(PROTOH_TIME))) {
                     line = line.mid(qstrlen(PROTOH_TIME));
@@ -633,7 +885,7 @@ bool Connection::parse() {
                     return false;
                 }
 
-                line = my_socket.readLine();
+                line = this->read_line();
 
                 if (! qstrncmp(line.data(), PROTOH_USER, qstrlen(PROTOH_USER))) {
                     log.user =  line.mid(qstrlen(PROTOH_USER));
@@ -645,7 +897,7 @@ bool Connection::parse() {
                 }
 
                 my_simlog.push_back(log);
-                line = my_socket.readLine();
+                line = this->read_line();
             }
 
             parsed = true;
@@ -654,7 +906,7 @@ bool Connection::parse() {
         } else if (! qstrncmp(line.data(), PROTOH_DO, qstrlen(PROTOH_DO))) {
             parsed = true;
             if (! qstrcmp(line.mid(qstrlen(PROTOH_DO)).data(), PROTOR_OK)) {
-                line = my_socket.readLine();
+                line = this->read_line();
                 if (! qstrncmp(line.data(), PROTOH_MSG, qstrlen(PROTOH_MSG))) {
                     my_msg = line.mid(qstrlen(PROTOH_MSG));
                     my_msg.resize(qstrlen(my_msg.toAscii()) - 2);// Odstrani \r\n
@@ -664,7 +916,7 @@ bool Connection::parse() {
                     return false;
                 }
             } else if (! qstrcmp(line.mid(qstrlen(PROTOH_DO)).data(), PROTOR_BAD)) {
-                line = my_socket.readLine();
+                line = this->read_line();
                 my_error = true;
                 if (! qstrncmp(line.data(), PROTOH_MSG, qstrlen(PROTOH_MSG))) {
                     my_msg = line.mid(qstrlen(PROTOH_MSG));
@@ -685,7 +937,7 @@ bool Connection::parse() {
             parsed = true;
             my_msg = line.mid(qstrlen(PROTOH_ADD));
 
-            line = my_socket.readLine();
+            line = this->read_line();
             line.chop(2);
 
             if (qstrncmp(line.data(), PROTOH_VERSION, qstrlen(PROTOH_VERSION))) {
@@ -714,11 +966,29 @@ bool Connection::parse() {
 }
 
 /**
- * \brief Metoda pre zaslanie zostaveneho poziadavku na server.
+ * \brief Nacitanie jedneho riadku odpovedi, na chybajuce data sa caka.
+ * \return Nacitany riadok, prazdny ak server neodpovedal alebo ukoncil spojenie.
+ */
+QByteArray Connection::read_line() {
+    while (! my_socket.canReadLine()) {
+        if (! my_socket.waitForReadyRead(CONNECTION_TIMEOUT))
+            return QByteArray();
+    }
+
+    return my_socket.readLine();
+}
+
+/**
+ * \brief Metoda pre zaslanie zostaveneho poziadavku na server v ramci
+ * binarneho protokolu. Spojenie sa udrziava otvorene a dalsie poziadavky ho
+ * vyuziju, kym ho server neukonci.
  * \return Informacia o spravnom zaslani poziadavku.
  * \retval false v pripade chyby.
  */
 bool Connection::send() {
+    QByteArray frame;
+    bool reused;
+
     my_error = false;
 
     if (! my_connected) {
@@ -727,29 +997,49 @@ bool Connection::send() {
         return false;
     }
 
-    my_socket.connectToHost(my_host, my_port);
-
-    if (my_socket.waitForConnected(CONNECTION_TIMEOUT)) {
-        qDebug() << "Connected to host:" << my_host << ":" << my_port;
+    if (! proto_frame(frame, my_fields, my_body)) {
+        my_error = true;
+        my_msg = QObject::tr("Request too large.");
+        return false;
+    }
 
-        my_socket.write(my_request.toAscii());
-        my_socket.flush();
+    reused = my_socket.state() == QAbstractSocket::ConnectedState;
+    if (! reused) {
+        my_socket.connectToHost(my_host, my_port);
 
-        if (my_socket.waitForReadyRead(CONNECTION_TIMEOUT)) {
-            qDebug() << "Recieving answer";
-            this->parse();
-        } else {
+        if (! my_socket.waitForConnected(CONNECTION_TIMEOUT)) {
             my_error = true;
-            my_msg = QObject::tr("Unable to receive answer.");
+            my_msg = QObject::tr("Unable to connect to host.");
+            my_socket.abort();
+            return false;
         }
+
+        qDebug() << "Connected to host:" << my_host << ":" << my_port;
+    }
+
+    my_socket.write(frame);
+    my_socket.flush();
+
+    if (my_socket.waitForReadyRead(my_wait)) {
+        qDebug() << "Recieving answer";
+        this->parse();
+    } else if (reused
+               && my_socket.state() != QAbstractSocket::ConnectedState) {
+        // Server medzitym ukoncil necinne spojenie, poziadavok sa zasle
+        // znovu novym spojenim.
+        my_socket.abort();
+        return this->send();
     } else {
         my_error = true;
-        my_msg = QObject::tr("Unable to connect to host.");
+        my_msg = QObject::tr("Unable to receive answer.");
     }
 
-    my_socket.disconnectFromHost();
-    qDebug() << "Disconnected from host.";
+    // Po chybe nemusi byt odpoved precitana cela, spojenie sa ukonci.
+    if (my_error || ! my_keep) {
+        my_socket.disconnectFromHost();
+        my_keep = false;
+        qDebug() << "Disconnected from host.";
+    }
 
     return ! my_error;
 }
-
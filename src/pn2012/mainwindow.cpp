@@ -10,6 +10,8 @@
 #include <QFileDialog>
 #include <QGraphicsScene>
 #include <QSignalMapper>
+#include <QStatusBar>
+#include <QHash>
 
 #include <pn/client/mainwindow.h>
 #include <pn/client/aboutwindow.h>
@@ -366,23 +368,19 @@ void MainWindow::on_actionStep_triggered()
 
     }
 
-    QString xml;
-    project->xml(xml);
-    Connection::instance()->req_step(xml,
-                                     project->servername(),
-                                     project->version());
-
-
-    if (Connection::instance()->error()) {
+    if (! this->simulate(project, false)) {
         QMessageBox msgBox(QMessageBox::Critical, tr("Failed"),
                            Connection::instance()->msg());
         msgBox.exec();
         return;
     }
 
-    this->xml_to_scene(Connection::instance()->xml(), project->filename(),
-                       project);
-
+    // Simulacia bola prerusena limitom servru.
+    if (! Connection::instance()->msg().isEmpty()) {
+        QMessageBox msgBox(QMessageBox::Information, tr("Simulation"),
+                           Connection::instance()->msg());
+        msgBox.exec();
+    }
 }
 
 /**
@@ -411,22 +409,93 @@ void MainWindow::on_actionRun_triggered()
 
     }
 
-    QString xml;
-    project->xml(xml);
-    Connection::instance()->req_run(xml,
-                                     project->servername(),
-                                     project->version());
-
-
-    if (Connection::instance()->error()) {
+    if (! this->simulate(project, true)) {
         QMessageBox msgBox(QMessageBox::Critical, tr("Failed"),
                            Connection::instance()->msg());
         msgBox.exec();
         return;
     }
 
-    this->xml_to_scene(Connection::instance()->xml(), project->filename(),
-                       project);
+    // Simulacia bola prerusena limitom servru.
+    if (! Connection::instance()->msg().isEmpty()) {
+        QMessageBox msgBox(QMessageBox::Information, tr("Simulation"),
+                           Connection::instance()->msg());
+        msgBox.exec();
+    }
+}
+
+/**
+ * \brief Simulacia projektu na serveri. Siet sa zasiela len pri otvoreni
+ * simulacie na serveri, dalsie kroky pokracuju v otvorenej simulacii, kym
+ * uzivatel siet neupravi. Server odpoveda len zmenenymi miestami.
+ * \param project simulovany projekt
+ * \param run true pre odsimulovanie, false pre krok simulacie
+ * \return false pri chybe, popis chyby je v Connection::msg()
+ */
+bool MainWindow::simulate(Project * project, bool run) {
+    Connection * conn = Connection::instance();
+    bool opened = false;
+    QString xml;
+
+    project->xml(xml);
+    for (;;) {
+        if (project->session().isEmpty() || project->session_xml() != xml) {
+            // Siet bola upravena, simulacia sa na serveri otvori znovu.
+            if (! project->session().isEmpty())
+                conn->req_close(project->session());
+
+            project->set_session(QString(), QString());
+            if (! conn->req_open(xml, project->servername(),
+                                 project->version()))
+                return false;
+
+            project->set_session(conn->session(), xml);
+            opened = true;
+        }
+
+        if (run)
+            conn->req_session_run(project->session(), true);
+        else
+            conn->req_session_step(project->session(), true);
+
+        if (! conn->error())
+            break;
+
+        // Simulacia na serveri mohla byt zatvorena pre necinnost, alebo po
+        // chybe nezodpoveda sieti projektu.
+        project->set_session(QString(), QString());
+        if (opened)
+            return false;
+    }
+
+    // Server zaslal len zmenene miesta, tie sa upravia priamo v scene.
+    QHash<QString, Place *> places;
+    foreach (QGraphicsItem * item, project->items()) {
+        Place * place = dynamic_cast<Place *>(item);
+        if (place)
+            places.insert(place->name(), place);
+    }
+
+    for (PlaceRecord_iter it = conn->req_delta_begin();
+            it != conn->req_delta_end(); ++it) {
+        Place * place = places.value(it->name, 0);
+        if (! place)
+            continue;
+
+        place->set_value(it->value);
+        place->setToolTip("Tokens: " + it->value);
+        place->update();
+    }
+
+    if (conn->fired().isEmpty())
+        this->statusBar()->showMessage(tr("No transition fired"));
+    else
+        this->statusBar()->showMessage(tr("Fired: %1")
+                                       .arg(conn->fired().join(", ")));
+
+    project->xml(xml);
+    project->set_session(project->session(), xml);
+    return true;
 }
 
 /**
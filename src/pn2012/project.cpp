@@ -439,6 +439,33 @@ const QString & Project::servername() const {
     return my_servername;
 }
 
+/**
+ * \brief Nastavenie simulacie otvorenej na serveri pre projekt.
+ * \param session identifikator simulacie, prazdny ak nie je otvorena
+ * \param xml siet projektu v stave, v ktorom je simulacia na serveri
+ */
+void Project::set_session(const QString & session, const QString & xml) {
+    my_session = session;
+    my_session_xml = xml;
+}
+
+/**
+ * \brief Ziskanie identifikatora simulacie otvorenej na serveri.
+ * \return identifikator simulacie, prazdny ak nie je otvorena
+ */
+const QString & Project::session() const {
+    return my_session;
+}
+
+/**
+ * \brief Ziskanie siete v stave, v ktorom je simulacia na serveri. Ak sa siet
+ * projektu odvtedy zmenila, simulaciu je nutne otvorit znovu.
+ * \return XML siete
+ */
+const QString & Project::session_xml() const {
+    return my_session_xml;
+}
+
 /**
  * \brief Informacia o tom, ci projekt bol zo servru.
  * \return true ak projekt je zo serveru
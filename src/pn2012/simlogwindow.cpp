@@ -14,6 +14,11 @@
 
 #include "ui_simlogwindow.h"
 
+/**
+ * \brief Najvacsi pocet zobrazenych zaznamov logu, zobrazuju sa najnovsie.
+ */
+const unsigned SIMLOG_PAGE = 1000;
+
 /**
  * \brief Konstruktor.
  */
@@ -53,7 +58,19 @@ bool simlogWindow::error()
  */
 void simlogWindow::refresh(QString & pname, unsigned version)
 {
-    Connection::instance()->req_simlog(pname, version);
+    unsigned total, offset = 0;
+
+    // Najprv sa zisti pocet zaznamov, potom sa stiahnu len tie najnovsie.
+    Connection::instance()->req_simlog(pname, version, 0, 1);
+    total = Connection::instance()->req_simlog_total();
+    if (! Connection::instance()->error() && total > SIMLOG_PAGE) {
+        offset = total - SIMLOG_PAGE;
+        this->setWindowTitle(this->windowTitle()
+                             + tr(" (last %1 of %2)").arg(SIMLOG_PAGE)
+                                                     .arg(total));
+    }
+    if (! Connection::instance()->error())
+        Connection::instance()->req_simlog(pname, version, offset, SIMLOG_PAGE);
 
     if (Connection::instance()->error()) {
         my_error = true;
@@ -7,6 +7,7 @@
  */
 #include <QList>
 #include <QString>
+#include <QHash>
 #include <QPointF>
 #include <QDebug>
 #include <QXmlStreamReader>
@@ -117,20 +118,20 @@ bool PNList::parse_arrow(ADepList & alist,
     if (arrow->name().isEmpty())
         return false;
 
-    ArrowDep * list_item = new ArrowDep;
+    ArrowDep list_item;
 
-    list_item->arrow = arrow;
-    list_item->from = attributes.value(XML_FROM).toString();
-    list_item->to = attributes.value(XML_TO).toString();
+    list_item.arrow = arrow;
+    list_item.from = attributes.value(XML_FROM).toString();
+    list_item.to = attributes.value(XML_TO).toString();
 
-    alist.push_back(list_item);
-
-    if (list_item->from.isEmpty())
+    if (list_item.from.isEmpty())
         return false;
 
-    if (list_item->to.isEmpty())
+    if (list_item.to.isEmpty())
         return false;
 
+    alist.push_back(list_item);
+
     return true;
 }
 
@@ -224,6 +225,21 @@ bool PNList::parse_transition(const QXmlStreamAttributes & attributes) {
     return true;
 }
 
+/**
+ * \brief Zaradenie naposledy rozparsovaneho objektu do indexu podla mena.
+ * \param names index objektov podla mena
+ * \return false v pripade, ze objekt s rovnakym menom uz existuje
+ */
+bool PNList::index(NameIndex & names) {
+    PNObject * obj = my_list.back();
+
+    if (names.contains(obj->name()))
+        return false;
+
+    names.insert(obj->name(), obj);
+    return true;
+}
+
 /**
  * \brief Rozparsovanie a vytvorenie prvkov petriho siete, ktore budu vlozene do
  * zoznamu na zaklade XML suboru.
@@ -234,6 +250,7 @@ bool PNList::parse_transition(const QXmlStreamAttributes & attributes) {
 bool PNList::from_xml(const QString & data, bool server) {
     QXmlStreamReader xml(data);
     ADepList alist;
+    NameIndex names;
 
     my_error.clear();
 
@@ -274,6 +291,13 @@ bool PNList::from_xml(const QString & data, bool server) {
                 my_error = QObject::tr("Unknown xml element type.");
                 return false;
             }
+
+            if (! this->index(names)) {
+                this->clear();
+                qDebug() << "Duplicit object name.";
+                my_error = QObject::tr("Duplicit object name.");
+                return false;
+            }
         }
         else if (xml.hasError()) {
             this->clear();
@@ -288,57 +312,58 @@ bool PNList::from_xml(const QString & data, bool server) {
      * Zoznam je vytvoreny z XML, ale treba nastavit zavislosti medzi sipkou a
      * ostatnymi objektami v svene.
      */
-    return this->compose(alist);
+    if (! this->compose(alist, names)) {
+        this->clear();
+        my_error = QObject::tr("Arrow references unknown object.");
+        return false;
+    }
+
+    return true;
 }
 
 
 /**
  * \brief Zistenie a vytvorenie zavislosti medzi sipkou a ostatnymi objektami.
+ * Objekty sa vyhladavaju v indexe podla mena, kazda sipka sa spracuje raz.
+ * \param alist zavislosti sipok zistene pri parsovani
+ * \param names index objektov podla mena
  * \return false v pripade, ze XML ma nekonzistentne zavislosti
  */
-bool PNList::compose(ADepList & alist) {
+bool PNList::compose(ADepList & alist, const NameIndex & names) {
+    PNObject * from;
+    PNObject * to;
     Place * p;
     Transition *t;
 
-    // Prehlada vsetky objekty a pokial sa nazov rovna referencovanemu, nastavi
-    // from a to objekt sipky.
     for (ADepList_iter it = alist.begin(); it != alist.end(); ++it) {
-        for (PNList_iter jt = my_list.begin();
-                jt != my_list.end(); ++jt) {
-
-            if ((*jt)->name() == (*it)->from) {
-                (*it)->arrow->set_start_object((*jt));
-
-                if ((p = dynamic_cast<Place*>(*jt))) {
-                    p->addArrow((*it)->arrow);
-                } else if ((t = dynamic_cast<Transition*>(*jt))) {
-                    t->addArrow((*it)->arrow);
-                } else {
-                    // Sipka je smerovana z sipky.
-                    qDebug() << "Name error in objects - arrow name!";
-                    return false;
-                }
-
-            } else if ((*jt)->name() == (*it)->to) {
-                (*it)->arrow->set_end_object((*jt));
+        from = names.value(it->from, 0);
+        to = names.value(it->to, 0);
 
-                if ((p = dynamic_cast<Place*>(*jt))) {
-                    p->addArrow((*it)->arrow);
-                } else if ((t = dynamic_cast<Transition*>(*jt))) {
-                    t->addArrow((*it)->arrow);
-                } else {
-                    // Sipka je smerovana do sipky.
-                    qDebug() << "Name error in objects - arrow name!";
-                    return false;
-                }
-            }
+        // Nenasli sa objekty, ktore boli odkazovane -> chyba.
+        if (! from || ! to || from == to) {
+            qDebug() << "Name error in objects - name not found.";
+            return false;
+        }
 
+        it->arrow->set_start_object(from);
+        if ((p = dynamic_cast<Place*>(from))) {
+            p->addArrow(it->arrow);
+        } else if ((t = dynamic_cast<Transition*>(from))) {
+            t->addArrow(it->arrow);
+        } else {
+            // Sipka je smerovana z sipky.
+            qDebug() << "Name error in objects - arrow name!";
+            return false;
         }
 
-        // Nenasli sa objekty, ktore boli odkazovane -> chyba.
-        if (! (*it)->arrow->start_pnobject()
-                || ! (*it)->arrow->end_pnobject()) {
-            qDebug() << "Name error in objects - name not found.";
+        it->arrow->set_end_object(to);
+        if ((p = dynamic_cast<Place*>(to))) {
+            p->addArrow(it->arrow);
+        } else if ((t = dynamic_cast<Transition*>(to))) {
+            t->addArrow(it->arrow);
+        } else {
+            // Sipka je smerovana do sipky.
+            qDebug() << "Name error in objects - arrow name!";
             return false;
         }
     }
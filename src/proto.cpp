@@ -21,11 +21,43 @@ const char * PROTOH_USER      = "USER: ";
 const char * PROTOH_TIME      = "TIME: ";
 const char * PROTOH_VERSION   = "VERSION: ";
 const char * PROTOH_MSG       = "MSG: ";
+const char * PROTOH_SESSION   = "SESSION: ";
+const char * PROTOH_PLACE     = "PLACE: ";
+const char * PROTOH_VALUE     = "VALUE: ";
+const char * PROTOH_FIRED     = "FIRED: ";
+// Limity simulacie.
+const char * PROTOH_STEPS     = "STEPS: ";
+const char * PROTOH_TIMEOUT   = "TIMEOUT: ";
+const char * PROTOH_TOKENS    = "TOKENS: ";
+// Dotaz na log simulacii.
+const char * PROTOH_FROM      = "FROM: ";
+const char * PROTOH_TO        = "TO: ";
+const char * PROTOH_OFFSET    = "OFFSET: ";
+const char * PROTOH_LIMIT     = "LIMIT: ";
+const char * PROTOH_TOTAL     = "TOTAL: ";
+const char * PROTOH_COUNT     = "COUNT: ";
+const char * PROTOH_FIRST     = "FIRST: ";
+const char * PROTOH_LAST      = "LAST: ";
+// Suborova simulacia.
+const char * PROTOH_MARKING   = "MARKING: ";
+const char * PROTOH_RESULT    = "RESULT: ";
+// Analyza dosiahnutelnosti.
+const char * PROTOH_MEMORY    = "MEMORY: ";
+const char * PROTOH_EDGES     = "EDGES: ";
+const char * PROTOH_DEADLOCKS = "DEADLOCKS: ";
+const char * PROTOH_BOUND     = "BOUND: ";
 // Viacriadkove odpovede.
 const char * PROTOH_LIST      = "LIST:\r\n";
 const char * PROTOH_VLIST     = "VLIST:\r\n";
 const char * PROTOH_XML       = "XML:\r\n";
 const char * PROTOH_SIMLOG    = "SIMLOG:\r\n";
+const char * PROTOH_DELTA     = "DELTA:\r\n";
+const char * PROTOH_STATS     = "STATS:\r\n";
+const char * PROTOH_BATCH     = "BATCH:\r\n";
+const char * PROTOH_REACH     = "REACH:\r\n";
+// Udrziavane spojenie.
+const char * PROTOH_KEEP      = "KEEP:\r\n";
+const char * PROTOH_FRAMES    = "FRAMES:\r\n";
 const char * PROTOH_ADD       = "ADD: ";
 // Atributy odpovedi.
 const char * PROTOR_AUTH      = "AUTH\r\n";
@@ -38,6 +70,11 @@ const char * PROTOR_ADD       = "ADD\r\n";
 const char * PROTOR_STEP      = "STEP\r\n";
 const char * PROTOR_RUN       = "RUN\r\n";
 const char * PROTOR_SIMLOG    = "SIMLOG\r\n";
+const char * PROTOR_OPEN      = "OPEN\r\n";
+const char * PROTOR_RESET     = "RESET\r\n";
+const char * PROTOR_CLOSE     = "CLOSE\r\n";
+const char * PROTOR_BATCH     = "BATCH\r\n";
+const char * PROTOR_REACH     = "REACH\r\n";
 
 const char * PROTOR_BAD       = "BAD\r\n";
 const char * PROTOR_OK        = "OK\r\n";
@@ -73,6 +110,16 @@ enum Req_type proto_byte2reqt(const QByteArray & bytea) {
         return REQ_STEP;
     } else if (! qstrcmp(bytea.data(), PROTOR_RUN)) {
         return REQ_RUN;
+    } else if (! qstrcmp(bytea.data(), PROTOR_OPEN)) {
+        return REQ_OPEN;
+    } else if (! qstrcmp(bytea.data(), PROTOR_RESET)) {
+        return REQ_RESET;
+    } else if (! qstrcmp(bytea.data(), PROTOR_CLOSE)) {
+        return REQ_CLOSE;
+    } else if (! qstrcmp(bytea.data(), PROTOR_BATCH)) {
+        return REQ_BATCH;
+    } else if (! qstrcmp(bytea.data(), PROTOR_REACH)) {
+        return REQ_REACH;
     } else {
         return REQ_NULL;
     }
@@ -128,6 +175,26 @@ const QByteArray proto_reqt2byte(enum Req_type type) {
             rv = PROTOR_SIMLOG;
             break;
 
+        case REQ_OPEN:
+            rv = PROTOR_OPEN;
+            break;
+
+        case REQ_RESET:
+            rv = PROTOR_RESET;
+            break;
+
+        case REQ_CLOSE:
+            rv = PROTOR_CLOSE;
+            break;
+
+        case REQ_BATCH:
+            rv = PROTOR_BATCH;
+            break;
+
+        case REQ_REACH:
+            rv = PROTOR_REACH;
+            break;
+
         case REQ_NULL:
             /* WALKTHRU */
         default:
@@ -138,3 +205,68 @@ const QByteArray proto_reqt2byte(enum Req_type type) {
     return rv;
 }
 
+
+/**
+ * \brief Pripojenie cisla v poradi bajtov siete.
+ * \param data Ciel.
+ * \param value Cislo.
+ * \param size Pocet bajtov cisla.
+ */
+static void proto_put(QByteArray & data, quint32 value, int size) {
+    while (size--)
+        data.append(char((value >> (8 * size)) & 0xff));
+}
+
+/**
+ * \brief Pripojenie polozky ramca binarneho protokolu - retazca bez \r\n,
+ * alebo polozky bez hodnoty pri prazdnom retazci.
+ * \param fields Polozky ramca.
+ * \param field Znacka polozky.
+ * \param value Hodnota polozky.
+ * \retval void
+ */
+void proto_put_field(QByteArray & fields, enum Proto_field field,
+                     const QByteArray & value) {
+    fields.append(char(field));
+    proto_put(fields, value.size(), 2);
+    fields.append(value);
+}
+
+/**
+ * \brief Pripojenie ciselnej polozky ramca binarneho protokolu (32 b).
+ * \param fields Polozky ramca.
+ * \param field Znacka polozky.
+ * \param value Hodnota polozky.
+ * \retval void
+ */
+void proto_put_number(QByteArray & fields, enum Proto_field field,
+                      unsigned value) {
+    fields.append(char(field));
+    proto_put(fields, 4, 2);
+    proto_put(fields, value, 4);
+}
+
+/**
+ * \brief Zostavenie ramca binarneho protokolu z poloziek (proto_put_field(),
+ * proto_put_number()) a tela s XML daty.
+ * \param frame Vysledny ramec.
+ * \param fields Polozky ramca.
+ * \param body Telo ramca.
+ * \return false ak sa polozky do ramca nezmestia (viac ako 64 KiB).
+ */
+bool proto_frame(QByteArray & frame, const QByteArray & fields,
+                 const QByteArray & body) {
+    if (fields.size() > 0xffff)
+        return false;
+
+    frame.clear();
+    frame.reserve(PROTO_FRAME_HEAD + fields.size() + body.size());
+    frame.append(PROTO_FRAME_MAGIC);
+    frame.append(char(0)); // Priznaky, zatial nevyuzite.
+    proto_put(frame, fields.size(), 2);
+    proto_put(frame, body.size(), 4);
+    frame.append(fields);
+    frame.append(body);
+
+    return true;
+}
@@ -8,11 +8,15 @@
 
 #include <QString>
 #include <QTime>
+#include <QIODevice>
+#include <QFile>
 
 #include <pn/server/answer.h>
 
 #include <pn/proto.h>
 #include <pn/server/projectdb.h>
+#include <pn/server/simulation.h>
+#include <pn/server/reachability.h>
 #include <pn/server/debug.h>
 
 const char * ANSWER_OK_AUTH_MSG      = "Logged in";
@@ -28,12 +32,22 @@ const char * ANSWER_BAD_REQ_MSG      = "Bad request";
 const char * ANSWER_BAD_DUPLICIT_MSG = "Duplicit request";
 const char * ANSWER_UNKNOWN_MSG      = "Unknown";
 const char * ANSWER_INTERNAL_ERR_MSG = "Internal error on server";
-const char * ANSWER_LIMIT_ERR_MSG    = "Simulation time exceeded!";
+const char * ANSWER_BUSY_MSG         = "Server busy";
+const char * ANSWER_OK_RESET_MSG     = "Simulation reset";
+const char * ANSWER_OK_CLOSE_MSG     = "Simulation closed";
+const char * ANSWER_BAD_SESSION_MSG  = "Unknown or busy simulation";
+const char * ANSWER_BAD_OPEN_MSG     = "Too many open simulations";
 
 /**
  * \brief - Konstuktor pre standardnu odpoved.
+ * \param out Zariadenie, do ktoreho sa odpoved zapise - socket klienta.
  */
-Answer::Answer() {
+Answer::Answer(QIODevice * out) {
+    Q_ASSERT(out);
+
+    my_out = out;
+    my_keep = false;
+    my_sent = false;
 }
 
 /**
@@ -95,6 +109,32 @@ void Answer::set_standard(enum Answer_msg msg) {
             my_header.append(PROTOR_BAD);
             my_header.append(PROTOH_MSG);
             my_header.append(ANSWER_INTERNAL_ERR_MSG);
+            break;
+        case ANSWER_BUSY:
+            my_header.append(PROTOR_BAD);
+            my_header.append(PROTOH_MSG);
+            my_header.append(ANSWER_BUSY_MSG);
+            break;
+        case ANSWER_OK_RESET:
+            my_header.append(PROTOR_OK);
+            my_header.append(PROTOH_MSG);
+            my_header.append(ANSWER_OK_RESET_MSG);
+            break;
+        case ANSWER_OK_CLOSE:
+            my_header.append(PROTOR_OK);
+            my_header.append(PROTOH_MSG);
+            my_header.append(ANSWER_OK_CLOSE_MSG);
+            break;
+        case ANSWER_BAD_SESSION:
+            my_header.append(PROTOR_BAD);
+            my_header.append(PROTOH_MSG);
+            my_header.append(ANSWER_BAD_SESSION_MSG);
+            break;
+        case ANSWER_BAD_OPEN:
+            my_header.append(PROTOR_BAD);
+            my_header.append(PROTOH_MSG);
+            my_header.append(ANSWER_BAD_OPEN_MSG);
+            break;
         case ANSWER_UNKNOWN:
         default:
             my_header.append(PROTOR_BAD);
@@ -129,25 +169,171 @@ void Answer::set_error(const QString & error) {
 void Answer::set_xml(ProjectDB & projects,
                      const QString & pname,
                      unsigned version) {
-    QString xml;
-    if (! projects.xml_data(xml, pname, version)) {
+    QFile file;
+    QByteArray xml;
+    qint64 size;
+    bool delta;
+    const uchar * ptr = projects.map_xml(file, size, delta, pname, version);
+
+    if (ptr) {
+        // Data sa zapisuju priamo z namapovaneho suboru.
+        this->set_xml(QByteArray::fromRawData(
+                          reinterpret_cast<const char *>(ptr), size));
+        file.unmap(const_cast<uchar *>(ptr));
+        return;
+    }
+
+    // Verzia ulozena ako rozdiel sa musi zostavit.
+    if (! delta || ! projects.xml_data(xml, pname, version)) {
         this->set_standard(ANSWER_INTERNAL_ERR);
         debug("E: XML: Internal error in XML (set xml)");
         return;
     }
 
-    my_header = PROTOH_XML;
-    my_header.append(xml).append(PROTO_EOL).append(PROTO_END);
+    this->set_xml(xml);
 }
 
 /**
- * \brief Nastavenie polozky XML v odpovedi.
+ * \brief Zapisanie polozky XML do odpovedi. XML data sa zapisuju priamo do
+ * zariadenia bez kopirovania do odpovedi. XML je vzdy ukoncene novym riadkom,
+ * aby klient pri udrziavanom spojeni precital odpoved presne po jej koniec.
  * \param  xml Vstupny subor v XML formate.
  * \retval void
  */
-void Answer::set_xml(const QString & xml) {
+void Answer::set_xml(const QByteArray & xml) {
     my_header = PROTOH_XML;
-    my_header.append(xml).append(PROTO_EOL).append(PROTO_END);
+    this->begin();
+
+    my_out->write(xml);
+    if (! xml.endsWith('\n'))
+        my_out->write("\n");
+    my_out->write(PROTO_EOL);
+    my_out->write(PROTO_END);
+}
+
+/**
+ * \brief Zapisanie vysledku simulacie v XML do odpovedi. Pri vycerpani limitu
+ * simulacie je zaslana aj polozka MSG. Siet sa zapisuje priamo do zariadenia
+ * bez zostavenia celeho XML v pamati.
+ * \param sim Odsimulovana simulacia.
+ * \retval void
+ */
+void Answer::set_xml(const Simulation & sim) {
+    my_header.clear();
+    if (! sim.limit().isEmpty())
+        my_header.append(PROTOH_MSG).append(sim.limit()).append(PROTO_EOL);
+    my_header.append(PROTOH_XML);
+    this->begin();
+
+    sim.net().xml(my_out, sim.marking());
+    my_out->write(PROTO_EOL);
+    my_out->write(PROTO_END);
+}
+
+/**
+ * \brief Nastavenie vysledku simulacie ako zmien siete - miesta, ktorych
+ * tokeny sa zmenili, a uspesne prechody. Pri vycerpani limitu simulacie je
+ * zaslana aj polozka MSG.
+ * \param sim Odsimulovana simulacia.
+ * \retval void
+ */
+void Answer::set_delta(const Simulation & sim) {
+    const SimNet & net = sim.net();
+
+    my_header.clear();
+    if (! sim.limit().isEmpty())
+        my_header.append(PROTOH_MSG).append(sim.limit()).append(PROTO_EOL);
+
+    my_header.append(PROTOH_DELTA);
+    foreach (int p, sim.changed()) {
+        my_header.append(PROTOH_PLACE).append(net.place(p).name);
+        my_header.append(PROTO_EOL);
+        my_header.append(PROTOH_VALUE).append(SimNet::value(sim.marking()[p]));
+        my_header.append(PROTO_EOL);
+    }
+    foreach (int t, sim.fired()) {
+        my_header.append(PROTOH_FIRED).append(net.transition(t).name);
+        my_header.append(PROTO_EOL);
+    }
+    my_header.append(PROTO_END);
+}
+
+/**
+ * \brief Nastavenie vysledku suborovej simulacie. Vysledok je zapisany po
+ * miestach - pre kazde miesto jeho tokeny vo vsetkych simulaciach v poradi
+ * simulacii. Simulacie, ktore neskoncili samy, su uvedene polozkou RESULT.
+ * \param net Odsimulovana siet.
+ * \param runs Simulacie s vyslednym znackovanim.
+ * \retval void
+ */
+void Answer::set_batch(const SimNet & net, const QVector<SimRun> & runs) {
+    my_header = PROTOH_BATCH;
+    my_header.append(PROTOH_COUNT).append(QByteArray::number(runs.size()));
+    my_header.append(PROTO_EOL);
+
+    for (int i = 0; i < runs.size(); ++i) {
+        if (runs[i].error.isEmpty() && runs[i].limit.isEmpty())
+            continue;
+
+        my_header.append(PROTOH_RESULT).append(QByteArray::number(i + 1));
+        if (! runs[i].error.isEmpty())
+            my_header.append(" ERROR ").append(runs[i].error);
+        else
+            my_header.append(" LIMIT ").append(runs[i].limit);
+        my_header.append(PROTO_EOL);
+    }
+
+    for (int p = 0; p < net.place_count(); ++p) {
+        my_header.append(PROTOH_PLACE).append(net.place(p).name);
+        my_header.append(PROTO_EOL);
+        for (int i = 0; i < runs.size(); ++i) {
+            my_header.append(PROTOH_VALUE);
+            my_header.append(SimNet::value(runs[i].marking[p]));
+            my_header.append(PROTO_EOL);
+        }
+    }
+    my_header.append(PROTO_END);
+}
+
+/**
+ * \brief Nastavenie vysledku analyzy dosiahnutelnosti - pocty stavov, hran a
+ * mrtvych stavov, najvacsi pocet tokenov kazdeho miesta a prve mrtve stavy
+ * v zapise polozky MARKING. Ciastocna analyza je uvedena polozkou MSG.
+ * \param net Analyzovana siet.
+ * \param reach Vysledok analyzy.
+ * \retval void
+ */
+void Answer::set_reach(const SimNet & net, const Reachability & reach) {
+    my_header = PROTOH_REACH;
+    if (! reach.limit().isEmpty())
+        my_header.append(PROTOH_MSG).append(reach.limit()).append(PROTO_EOL);
+    my_header.append(PROTOH_COUNT).append(QByteArray::number(reach.states()));
+    my_header.append(PROTO_EOL);
+    my_header.append(PROTOH_EDGES).append(QByteArray::number(reach.edges()));
+    my_header.append(PROTO_EOL);
+    my_header.append(PROTOH_DEADLOCKS);
+    my_header.append(QByteArray::number(reach.deadlocks()));
+    my_header.append(PROTO_EOL);
+
+    for (int p = 0; p < net.place_count(); ++p) {
+        my_header.append(PROTOH_PLACE).append(net.place(p).name);
+        my_header.append(PROTO_EOL);
+        my_header.append(PROTOH_BOUND);
+        my_header.append(QByteArray::number(reach.bounds()[p]));
+        my_header.append(PROTO_EOL);
+    }
+
+    foreach (const SimMarking & marking, reach.deadlock_markings()) {
+        my_header.append(PROTOH_MARKING);
+        for (int p = 0; p < net.place_count(); ++p) {
+            if (p != 0)
+                my_header.append(';');
+            my_header.append(net.place(p).name).append('=');
+            my_header.append(SimNet::value(marking[p]));
+        }
+        my_header.append(PROTO_EOL);
+    }
+    my_header.append(PROTO_END);
 }
 
 /**
@@ -162,6 +348,17 @@ void Answer::set_add(unsigned version) {
     my_header.append(PROTO_EOL).append(PROTO_END);
 }
 
+/**
+ * \brief Pripravenie odpovedi pre otvorenie simulacie na serveri.
+ * \param session Identifikator otvorenej simulacie.
+ * \retval void
+ */
+void Answer::set_session(const QString & session) {
+    my_header = PROTOH_SESSION;
+    my_header.append(session);
+    my_header.append(PROTO_EOL).append(PROTO_END);
+}
+
 /**
  * \brief Pripravenie odpovedi pre VLIST - zoznam verzii na servri.
  * \param projects Databaza projektov z ktorej sa ma vybrat zadany projekt.
@@ -213,37 +410,96 @@ void Answer::set_list(ProjectDB & projects) {
 }
 
 /**
- * \brief Zostavenie odpovedi pre vypis logu zo simulacii.
+ * \brief Zostavenie odpovedi pre vypis logu zo simulacii. Pri dotaze na cast
+ * logu alebo suhrn je zaslany aj celkovy pocet zaznamov v casovom rozsahu.
  * \param projects Databaza projektov z ktorej sa ma vybrat zadany log.
  * \param pname Nazov projektu, z ktoreho sa ma log zostavit.
  * \param version Cislo verzie projektu pre log suboru.
+ * \param query Dotaz na cast logu.
+ * \param stats Pripojit suhrn simulacii podla uzivatelov.
  * \retval void
  */
 void Answer::set_simlog(ProjectDB & projects,
                         const QString & pname,
-                        unsigned version) {
+                        unsigned version,
+                        const SimlogQuery & query,
+                        bool stats) {
     QStringList simlog;
-    if (! projects.simlog(simlog, pname, version)) {
+    QList<SimlogUser> users;
+    unsigned total;
+
+    if (! projects.simlog(simlog, total, pname, version, query)
+        || (stats && ! projects.simlog_users(users, pname, version))) {
         this->set_standard(ANSWER_INTERNAL_ERR);
         debug("E: SIMLOG: Internal error");
         return;
     }
 
     my_header = PROTOH_SIMLOG;
+    if (query.from || query.to || query.offset || query.limit || stats) {
+        my_header.append(PROTOH_TOTAL).append(QByteArray::number(total));
+        my_header.append(PROTO_EOL);
+    }
+
     for (int i = 0; i < simlog.size(); ++i) {
         my_header.append(PROTOH_TIME).append(simlog[i]).append(PROTO_EOL);
         ++i; // mena su na neparnych poziciach
         my_header.append(PROTOH_USER).append(simlog[i]).append(PROTO_EOL);
     }
+
+    if (stats) {
+        my_header.append(PROTOH_STATS);
+        foreach (const SimlogUser & user, users) {
+            my_header.append(PROTOH_USER).append(user.username);
+            my_header.append(PROTO_EOL);
+            my_header.append(PROTOH_COUNT);
+            my_header.append(QByteArray::number(user.count)).append(PROTO_EOL);
+            my_header.append(PROTOH_FIRST);
+            my_header.append(QByteArray::number(user.first)).append(PROTO_EOL);
+            my_header.append(PROTOH_LAST);
+            my_header.append(QByteArray::number(user.last)).append(PROTO_EOL);
+        }
+    }
     my_header.append(PROTO_END);
 }
 
 /**
- * \brief Spristupnenie textu zostavenej odpovedi.
- * \return Spristupneny text odpovedi.
- * \retval const QString & spristupneny text odpovedi.
+ * \brief Oznacenie odpovedi, po ktorej server spojenie neukonci a caka na dalsi
+ * poziadavok. Volat pred zostavenim odpovedi, polozky sa zapisu na jej
+ * zaciatok. Server zaroven ponukne zasielanie dalsich poziadavkov v ramcoch
+ * binarneho protokolu.
+ * \retval void
+ */
+void Answer::set_keep() {
+    Q_ASSERT(! my_sent);
+
+    my_keep = true;
+}
+
+/**
+ * \brief Zapisanie zaciatku odpovedi (KEEP a zostavena cast) do zariadenia.
+ * Dalej sa do odpovedi zapisuje priamo.
+ * \retval void
+ */
+void Answer::begin() {
+    Q_ASSERT(! my_sent);
+
+    if (my_keep) {
+        my_out->write(PROTOH_KEEP);
+        my_out->write(PROTOH_FRAMES);
+    }
+    my_out->write(my_header);
+    my_header.clear();
+    my_sent = true;
+}
+
+/**
+ * \brief Zapisanie zostavenej odpovedi do zariadenia, pokial uz nebola
+ * zapisana priebezne.
+ * \retval void
  */
-const QString & Answer::text() const {
-    return my_header;
+void Answer::send() {
+    if (! my_sent)
+        this->begin();
 }
 
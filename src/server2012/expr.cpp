@@ -0,0 +1,853 @@
+/**
+ * \file     expr.cpp
+ * \brief    Preklad podmienok a modov prechodov do jednoducheho bajtkodu.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 05 2012
+ */
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QVarLengthArray>
+
+#include <climits>
+#include <cmath>
+
+#include <pn/server/expr.h>
+
+/**
+ * Klucove slova ECMAScriptu, ktore nemozu byt pouzite ako nazov premennej
+ * v prelozenom vyraze. Vyrazy s nimi sa vyhodnocuju pomocou QScriptEngine.
+ */
+const char * EXPR_RESERVED[] = {
+    "break", "case", "catch", "continue", "default", "delete", "do", "else",
+    "finally", "for", "function", "if", "in", "instanceof", "new", "return",
+    "switch", "this", "throw", "try", "typeof", "var", "void", "while", "with",
+    "null", "undefined", "NaN", "Infinity", 0
+};
+
+/**
+ * \brief Pravdivostna hodnota cisla podla ECMAScriptu.
+ * \param value hodnota
+ * \return false pre 0 a NaN
+ */
+static inline bool expr_truthy(double value) {
+    return value != 0 && value == value;
+}
+
+/**
+ * \brief Konstruktor.
+ */
+Expr::Expr() {
+    my_last = -1;
+    my_inputs = 0;
+    my_outputs = 0;
+    my_depth = 0;
+    my_max_depth = 0;
+    my_valid = false;
+    my_pos = 0;
+    my_token = T_END;
+    my_number = 0;
+}
+
+/**
+ * \brief Destruktor.
+ */
+Expr::~Expr() {
+}
+
+/**
+ * \brief Predikat pre zistenie, ci bol vyraz uspesne prelozeny.
+ * \return true ak je mozne vyraz vyhodnotit bez QScriptEngine
+ */
+bool Expr::valid() const {
+    return my_valid;
+}
+
+/**
+ * \brief Pocet slotov, ktore program potrebuje pre vyhodnotenie.
+ * \return velkost pola slotov
+ */
+int Expr::slot_count() const {
+    return my_vars.size();
+}
+
+/**
+ * \brief Predikat pre zistenie, ci mod priradzuje hodnotu vystupnej sipke.
+ * \param output index vystupnej sipky
+ * \return true ak ma vystupna sipka po vykonani modu hodnotu
+ */
+bool Expr::assigned(int output) const {
+    return my_defined[my_inputs + output];
+}
+
+/**
+ * \brief Prevod vysledku vyrazu na token (ToInteger z ECMAScriptu).
+ * \param value vysledok vyrazu
+ * \return hodnota tokenu
+ */
+int Expr::to_token(double value) {
+    if (value != value)
+        return 0;
+    if (value >= INT_MAX)
+        return INT_MAX;
+    if (value <= INT_MIN)
+        return INT_MIN;
+    return static_cast<int>(value);
+}
+
+/**
+ * \brief Inicializacia prekladu.
+ * \param src zdrojovy text vyrazu
+ * \param inputs nazvy vstupnych sipok
+ */
+void Expr::reset(const QString & src, const QStringList & inputs) {
+    my_code.clear();
+    my_conj.clear();
+    my_conj_offset.clear();
+    my_last = -1;
+    my_vars = inputs;
+    my_defined.fill(true, inputs.size());
+    my_inputs = inputs.size();
+    my_outputs = 0;
+    my_depth = 0;
+    my_max_depth = 0;
+    my_valid = false;
+
+    my_src = src;
+    my_pos = 0;
+    this->next();
+}
+
+/**
+ * \brief Vyhladanie slotu premennej.
+ * \param name nazov premennej
+ * \return index slotu, -1 ak premenna neexistuje
+ */
+int Expr::lookup(const QString & name) const {
+    return my_vars.indexOf(name);
+}
+
+/**
+ * \brief Pridanie instrukcie na koniec programu.
+ * \return index pridanej instrukcie
+ */
+int Expr::emit(enum Op op, int arg, double value) {
+    Instr instr;
+    instr.op = op;
+    instr.arg = arg;
+    instr.value = value;
+
+    switch (op) {
+        case OP_LOAD:
+            if (arg > my_last)
+                my_last = arg;
+            /* WALKTHRU */
+        case OP_CONST:
+            if (++my_depth > my_max_depth)
+                my_max_depth = my_depth;
+            break;
+
+        case OP_NEG:
+        case OP_NOT:
+        case OP_JUMP:
+            break;
+
+        default:
+            // Binarne operatory, ulozenie a podmienene skoky uberaju hodnotu.
+            my_depth--;
+            break;
+    }
+
+    my_code.push_back(instr);
+    return my_code.size() - 1;
+}
+
+/**
+ * \brief Nacitanie dalsej lexikalnej jednotky do my_token.
+ */
+void Expr::next() {
+    while (my_pos < my_src.size() && my_src[my_pos].isSpace())
+        ++my_pos;
+
+    if (my_pos >= my_src.size()) {
+        my_token = T_END;
+        return;
+    }
+
+    QChar c = my_src[my_pos];
+    QChar n = my_pos + 1 < my_src.size() ? my_src[my_pos + 1] : QChar();
+    char ch = c.toAscii();
+
+    if (c.unicode() > 127) {
+        my_token = T_ERROR;
+    } else if (c.isDigit() || (ch == '.' && n.isDigit())) {
+        int start = my_pos;
+
+        // Oktalove a sestnastkove zapisy nie su podporovane.
+        if (ch == '0' && (n.isDigit() || n == 'x' || n == 'X')) {
+            my_token = T_ERROR;
+            return;
+        }
+
+        while (my_pos < my_src.size() && my_src[my_pos].isDigit())
+            ++my_pos;
+        if (my_pos < my_src.size() && my_src[my_pos] == '.') {
+            ++my_pos;
+            while (my_pos < my_src.size() && my_src[my_pos].isDigit())
+                ++my_pos;
+        }
+
+        // Exponent ani identifikator za cislom nie su podporovane.
+        if (my_pos < my_src.size() && (my_src[my_pos].isLetterOrNumber()
+                    || my_src[my_pos] == '_' || my_src[my_pos] == '$')) {
+            my_token = T_ERROR;
+            return;
+        }
+
+        bool ok;
+        my_number = my_src.mid(start, my_pos - start).toDouble(&ok);
+        my_token = ok ? T_NUM : T_ERROR;
+        return;
+    } else if (c.isLetter() || ch == '_' || ch == '$') {
+        int start = my_pos;
+
+        while (my_pos < my_src.size() && my_src[my_pos].unicode() <= 127
+                && (my_src[my_pos].isLetterOrNumber()
+                    || my_src[my_pos] == '_' || my_src[my_pos] == '$'))
+            ++my_pos;
+
+        my_ident = my_src.mid(start, my_pos - start);
+        if (my_ident == "true") {
+            my_token = T_TRUE;
+        } else if (my_ident == "false") {
+            my_token = T_FALSE;
+        } else {
+            my_token = T_IDENT;
+            for (int i = 0; EXPR_RESERVED[i]; ++i) {
+                if (my_ident == EXPR_RESERVED[i])
+                    my_token = T_ERROR;
+            }
+        }
+        return;
+    }
+
+    ++my_pos;
+    switch (ch) {
+        case '(': my_token = T_LPAR; break;
+        case ')': my_token = T_RPAR; break;
+        case ';': my_token = T_SEMICOLON; break;
+        case '?': my_token = T_QUESTION; break;
+        case ':': my_token = T_COLON; break;
+        case '+':
+            my_token = (n == '+' || n == '=') ? T_ERROR : T_PLUS;
+            break;
+        case '-':
+            my_token = (n == '-' || n == '=') ? T_ERROR : T_MINUS;
+            break;
+        case '*':
+            my_token = n == '=' ? T_ERROR : T_MUL;
+            break;
+        case '/':
+            // Komentare a skratene priradenie nie su podporovane.
+            my_token = (n == '/' || n == '*' || n == '=') ? T_ERROR : T_DIV;
+            break;
+        case '%':
+            my_token = n == '=' ? T_ERROR : T_MOD;
+            break;
+        case '!':
+            if (n == '=') {
+                ++my_pos;
+                // Striktne porovnanie rozlisuje typy, ktore tu nie su.
+                my_token = (my_pos < my_src.size() && my_src[my_pos] == '=')
+                           ? T_ERROR : T_NE;
+            } else {
+                my_token = T_NOT;
+            }
+            break;
+        case '=':
+            if (n == '=') {
+                ++my_pos;
+                my_token = (my_pos < my_src.size() && my_src[my_pos] == '=')
+                           ? T_ERROR : T_EQ;
+            } else {
+                my_token = T_ASSIGN;
+            }
+            break;
+        case '<':
+            if (n == '<') {
+                my_token = T_ERROR;
+            } else if (n == '=') {
+                ++my_pos;
+                my_token = T_LE;
+            } else {
+                my_token = T_LT;
+            }
+            break;
+        case '>':
+            if (n == '>') {
+                my_token = T_ERROR;
+            } else if (n == '=') {
+                ++my_pos;
+                my_token = T_GE;
+            } else {
+                my_token = T_GT;
+            }
+            break;
+        case '&':
+            ++my_pos;
+            my_token = n == '&' ? T_AND : T_ERROR;
+            break;
+        case '|':
+            ++my_pos;
+            my_token = n == '|' ? T_OR : T_ERROR;
+            break;
+        default:
+            my_token = T_ERROR;
+            break;
+    }
+}
+
+/**
+ * \brief Vyraz vratane ternarneho operatora.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_expr() {
+    if (! this->parse_or())
+        return false;
+
+    if (my_token != T_QUESTION)
+        return true;
+
+    this->next();
+    int jfalse = this->emit(OP_JUMP_FALSE);
+    if (! this->parse_expr())
+        return false;
+    int jend = this->emit(OP_JUMP);
+    my_depth--; // Hodnota vetvy je na zasobniku len v jednej z vetiev.
+
+    if (my_token != T_COLON)
+        return false;
+    this->next();
+
+    my_code[jfalse].arg = my_code.size();
+    if (! this->parse_expr())
+        return false;
+    my_code[jend].arg = my_code.size();
+    return true;
+}
+
+/**
+ * \brief Logicky sucet.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_or() {
+    if (! this->parse_and())
+        return false;
+
+    while (my_token == T_OR) {
+        this->next();
+        int jump = this->emit(OP_OR);
+        if (! this->parse_and())
+            return false;
+        my_code[jump].arg = my_code.size();
+    }
+
+    return true;
+}
+
+/**
+ * \brief Logicky sucin.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_and() {
+    if (! this->parse_equality())
+        return false;
+
+    while (my_token == T_AND) {
+        this->next();
+        int jump = this->emit(OP_AND);
+        if (! this->parse_equality())
+            return false;
+        my_code[jump].arg = my_code.size();
+    }
+
+    return true;
+}
+
+/**
+ * \brief Operatory rovnosti.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_equality() {
+    if (! this->parse_relational())
+        return false;
+
+    while (my_token == T_EQ || my_token == T_NE) {
+        enum Op op = my_token == T_EQ ? OP_EQ : OP_NE;
+        this->next();
+        if (! this->parse_relational())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Relacne operatory.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_relational() {
+    if (! this->parse_additive())
+        return false;
+
+    for (;;) {
+        enum Op op;
+
+        switch (my_token) {
+            case T_LT: op = OP_LT; break;
+            case T_LE: op = OP_LE; break;
+            case T_GT: op = OP_GT; break;
+            case T_GE: op = OP_GE; break;
+            default:
+                return true;
+        }
+
+        this->next();
+        if (! this->parse_additive())
+            return false;
+        this->emit(op);
+    }
+}
+
+/**
+ * \brief Scitanie a odcitanie.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_additive() {
+    if (! this->parse_multiplicative())
+        return false;
+
+    while (my_token == T_PLUS || my_token == T_MINUS) {
+        enum Op op = my_token == T_PLUS ? OP_ADD : OP_SUB;
+        this->next();
+        if (! this->parse_multiplicative())
+            return false;
+        this->emit(op);
+    }
+
+    return true;
+}
+
+/**
+ * \brief Nasobenie, delenie a zvysok po deleni.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_multiplicative() {
+    if (! this->parse_unary())
+        return false;
+
+    for (;;) {
+        enum Op op;
+
+        switch (my_token) {
+            case T_MUL: op = OP_MUL; break;
+            case T_DIV: op = OP_DIV; break;
+            case T_MOD: op = OP_MOD; break;
+            default:
+                return true;
+        }
+
+        this->next();
+        if (! this->parse_unary())
+            return false;
+        this->emit(op);
+    }
+}
+
+/**
+ * \brief Unarne operatory.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_unary() {
+    enum Token token = my_token;
+
+    if (token != T_NOT && token != T_MINUS && token != T_PLUS)
+        return this->parse_primary();
+
+    this->next();
+    if (! this->parse_unary())
+        return false;
+
+    if (token == T_NOT)
+        this->emit(OP_NOT);
+    else if (token == T_MINUS)
+        this->emit(OP_NEG);
+
+    return true;
+}
+
+/**
+ * \brief Zakladne vyrazy - cisla, konstanty, premenne a zatvorky.
+ * \return false ak vyraz nie je v podporovanej podmnozine
+ */
+bool Expr::parse_primary() {
+    int slot;
+
+    switch (my_token) {
+        case T_NUM:
+            this->emit(OP_CONST, 0, my_number);
+            break;
+
+        case T_TRUE:
+            this->emit(OP_CONST, 0, 1);
+            break;
+
+        case T_FALSE:
+            this->emit(OP_CONST, 0, 0);
+            break;
+
+        case T_IDENT:
+            // Necitana premenna by v QScriptEngine vyvolala vynimku.
+            slot = this->lookup(my_ident);
+            if (slot < 0 || ! my_defined[slot])
+                return false;
+            this->emit(OP_LOAD, slot);
+            break;
+
+        case T_LPAR:
+            this->next();
+            if (! this->parse_expr() || my_token != T_RPAR)
+                return false;
+            break;
+
+        default:
+            return false;
+    }
+
+    this->next();
+    return true;
+}
+
+/**
+ * \brief Ulozenie operandu podmienky, ktory zacina instrukciou begin a konci
+ * poslednou prelozenou instrukciou.
+ * \param begin prva instrukcia operandu
+ */
+void Expr::add_conjunct(int begin) {
+    Conjunct conj;
+    conj.begin = begin;
+    conj.end = my_code.size();
+    conj.last = my_last;
+    conj.key = -1;
+    conj.other = -1;
+    conj.value = 0;
+
+    // Porovnanie v tvare slot == slot alebo slot == konstanta umoznuje
+    // vyhladat tokeny podla hodnoty.
+    const Instr * code = my_code.constData() + begin;
+    if (conj.end - begin == 3 && code[2].op == OP_EQ) {
+        if (code[0].op == OP_LOAD && code[1].op == OP_LOAD
+                && code[0].arg != code[1].arg) {
+            conj.key = my_last;
+            conj.other = qMin(code[0].arg, code[1].arg);
+        } else if (code[0].op == OP_LOAD && code[1].op == OP_CONST) {
+            conj.key = code[0].arg;
+            conj.value = code[1].value;
+        } else if (code[0].op == OP_CONST && code[1].op == OP_LOAD) {
+            conj.key = code[1].arg;
+            conj.value = code[0].value;
+        }
+    }
+
+    my_conj.push_back(conj);
+    my_last = -1;
+    my_depth = 0;
+}
+
+/**
+ * \brief Preklad podmienky prechodu.
+ * \param src text podmienky
+ * \param inputs nazvy vstupnych sipok prechodu v poradi slotov
+ * \return false ak podmienku nie je mozne prelozit
+ */
+bool Expr::compile_condition(const QString & src, const QStringList & inputs) {
+    this->reset(src, inputs);
+
+    if (my_vars.removeDuplicates() != 0)
+        return false;
+
+    if (my_token == T_END) {
+        // Prazdna podmienka sa vyhodnoti ako undefined, teda nepravda.
+        this->emit(OP_CONST, 0, 0);
+        this->add_conjunct(0);
+    } else {
+        // Operandy logickeho sucinu na najvyssej urovni sa prekladaju zvlast.
+        for (;;) {
+            int begin = my_code.size();
+            if (! this->parse_equality())
+                return false;
+            this->add_conjunct(begin);
+
+            if (my_token != T_AND)
+                break;
+            this->next();
+        }
+
+        if (my_token == T_OR || my_token == T_QUESTION) {
+            // Podmienka nie je logickym sucinom, preloz ju ako celok.
+            this->reset(src, inputs);
+            if (! this->parse_expr())
+                return false;
+            this->add_conjunct(0);
+        }
+
+        if (my_token == T_SEMICOLON)
+            this->next();
+    }
+
+    my_src.clear();
+    my_valid = my_token == T_END;
+    if (! my_valid)
+        return false;
+
+    // Zoradenie operandov podla najvyssieho slotu, v ramci slotu zostava
+    // poradie z podmienky.
+    QVector<Conjunct> conj;
+    my_conj_offset.fill(0, my_inputs + 2);
+    for (int s = -1; s < my_inputs; ++s) {
+        my_conj_offset[s + 1] = conj.size();
+        for (int i = 0; i < my_conj.size(); ++i) {
+            if (my_conj[i].last == s)
+                conj.push_back(my_conj[i]);
+        }
+    }
+    my_conj_offset[my_inputs + 1] = conj.size();
+    my_conj = conj;
+
+    return my_valid;
+}
+
+/**
+ * \brief Preklad modu prechodu.
+ * \param src text modu
+ * \param inputs nazvy vstupnych sipok prechodu v poradi slotov
+ * \param outputs nazvy vystupnych sipok prechodu v poradi slotov
+ * \return false ak mod nie je mozne prelozit
+ */
+bool Expr::compile_mode(const QString & src, const QStringList & inputs,
+                        const QStringList & outputs) {
+    this->reset(src, inputs);
+
+    my_outputs = outputs.size();
+    my_vars += outputs;
+    my_defined.resize(my_vars.size());
+    for (int i = my_inputs; i < my_vars.size(); ++i)
+        my_defined[i] = false;
+
+    if (my_vars.removeDuplicates() != 0)
+        return false;
+
+    for (;;) {
+        while (my_token == T_SEMICOLON)
+            this->next();
+
+        if (my_token == T_END)
+            break;
+
+        // Podporovany je len prikaz v tvare: premenna = vyraz
+        if (my_token != T_IDENT)
+            return false;
+
+        QString name = my_ident;
+        this->next();
+        if (my_token != T_ASSIGN)
+            return false;
+        this->next();
+
+        if (! this->parse_expr())
+            return false;
+
+        int slot = this->lookup(name);
+        if (slot < 0) {
+            // Pomocna premenna modu.
+            my_vars.append(name);
+            my_defined.append(false);
+            slot = my_vars.size() - 1;
+        }
+
+        this->emit(OP_STORE, slot);
+        my_defined[slot] = true;
+
+        if (my_token != T_SEMICOLON && my_token != T_END)
+            return false;
+    }
+
+    my_src.clear();
+    my_valid = true;
+    return my_valid;
+}
+
+/**
+ * \brief Vykonanie casti programu nad polom slotov.
+ * \param slots hodnoty premennych
+ * \param begin prva instrukcia
+ * \param end instrukcia za poslednou vykonanou instrukciou
+ * \return hodnota na vrchole zasobnika po skonceni programu
+ */
+double Expr::run(double * slots, int begin, int end) const {
+    QVarLengthArray<double, 32> stack(my_max_depth + 1);
+    double * st = stack.data();
+    const Instr * code = my_code.constData();
+    int top = -1;
+
+    for (int pc = begin; pc < end; ++pc) {
+        const Instr & instr = code[pc];
+
+        switch (instr.op) {
+            case OP_CONST:
+                st[++top] = instr.value;
+                break;
+            case OP_LOAD:
+                st[++top] = slots[instr.arg];
+                break;
+            case OP_STORE:
+                slots[instr.arg] = st[top--];
+                break;
+            case OP_NEG:
+                st[top] = -st[top];
+                break;
+            case OP_NOT:
+                st[top] = expr_truthy(st[top]) ? 0 : 1;
+                break;
+            case OP_ADD:
+                --top;
+                st[top] = st[top] + st[top + 1];
+                break;
+            case OP_SUB:
+                --top;
+                st[top] = st[top] - st[top + 1];
+                break;
+            case OP_MUL:
+                --top;
+                st[top] = st[top] * st[top + 1];
+                break;
+            case OP_DIV:
+                --top;
+                st[top] = st[top] / st[top + 1];
+                break;
+            case OP_MOD:
+                --top;
+                st[top] = std::fmod(st[top], st[top + 1]);
+                break;
+            case OP_EQ:
+                --top;
+                st[top] = st[top] == st[top + 1];
+                break;
+            case OP_NE:
+                --top;
+                st[top] = st[top] != st[top + 1];
+                break;
+            case OP_LT:
+                --top;
+                st[top] = st[top] < st[top + 1];
+                break;
+            case OP_LE:
+                --top;
+                st[top] = st[top] <= st[top + 1];
+                break;
+            case OP_GT:
+                --top;
+                st[top] = st[top] > st[top + 1];
+                break;
+            case OP_GE:
+                --top;
+                st[top] = st[top] >= st[top + 1];
+                break;
+            case OP_AND:
+                // Instrukcia skoku sa nevykona, cyklus este zvysi pc.
+                if (! expr_truthy(st[top]))
+                    pc = instr.arg - 1;
+                else
+                    --top;
+                break;
+            case OP_OR:
+                if (expr_truthy(st[top]))
+                    pc = instr.arg - 1;
+                else
+                    --top;
+                break;
+            case OP_JUMP_FALSE:
+                if (! expr_truthy(st[top--]))
+                    pc = instr.arg - 1;
+                break;
+            case OP_JUMP:
+                pc = instr.arg - 1;
+                break;
+        }
+    }
+
+    return top >= 0 ? st[top] : 0;
+}
+
+/**
+ * \brief Vyhodnotenie prelozenej podmienky.
+ * \param slots hodnoty vstupnych sipok
+ * \return pravdivostna hodnota podmienky
+ */
+bool Expr::condition(double * slots) const {
+    Q_ASSERT(my_valid);
+    for (int i = 0; i < my_conj.size(); ++i) {
+        if (! expr_truthy(this->run(slots, my_conj[i].begin, my_conj[i].end)))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \brief Vyhodnotenie operandov podmienky, ktorych najvyssi pouzity slot je
+ * slot. Ostatne operandy sa nevyhodnocuju.
+ * \param slot najvyssi pouzity slot, -1 pre operandy bez premennych
+ * \param slots hodnoty vstupnych sipok az po slot
+ * \return false ak niektory z operandov nie je pravdivy
+ */
+bool Expr::check(int slot, double * slots) const {
+    Q_ASSERT(my_valid);
+    for (int i = my_conj_offset[slot + 1]; i < my_conj_offset[slot + 2]; ++i) {
+        if (! expr_truthy(this->run(slots, my_conj[i].begin, my_conj[i].end)))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \brief Vyhladanie operandu v tvare slot == other alebo slot == value, kde
+ * other je nizsi slot.
+ * \param slot slot, pre ktory sa porovnanie hlada
+ * \param other nizsi slot porovnania, -1 ak sa porovnava s konstantou
+ * \param value konstanta porovnania
+ * \return false ak taky operand neexistuje
+ */
+bool Expr::key(int slot, int & other, double & value) const {
+    Q_ASSERT(my_valid);
+    for (int i = my_conj_offset[slot + 1]; i < my_conj_offset[slot + 2]; ++i) {
+        if (my_conj[i].key == slot) {
+            other = my_conj[i].other;
+            value = my_conj[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * \brief Vykonanie prelozeneho modu, vysledky su ulozene v slotoch vystupnych
+ * sipok.
+ * \param slots hodnoty vstupnych sipok, vystupnych sipok a pomocnych premennych
+ */
+void Expr::mode(double * slots) const {
+    Q_ASSERT(my_valid);
+    this->run(slots, 0, my_code.size());
+}
@@ -9,10 +9,11 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
-#include <QApplication>
+#include <QCoreApplication>
 #include <signal.h>
 
 #include <pn/server/server2012.h>
+#include <pn/server/simulation.h>
 
 /**
  * \brief Struktura pre spracovane odpovede.
@@ -34,6 +35,10 @@ struct Param {
      * \brief cesta k databazy projektov
      */
     const char * projectdb;
+    /**
+     * \brief nastavenia servru (limity simulacie, vlakna)
+     */
+    ServerConfig config;
 };
 
 /**
@@ -51,12 +56,57 @@ void print_help(const char * pname) {
          << "\t-h\t\t- print this simple help\n"
          << "\t-p PORT\t\t- specify port to be used\n"
          << "\t--userdb FILE\t- texfile with registered users\n"
-         << "\t--projectdb DIR\t- directory with a project tree\n";
+         << "\t--projectdb DIR\t- directory with a project tree\n"
+         << "\t--sim-steps N\t- maximum number of steps of a simulation\n"
+         << "\t--sim-time MS\t- maximum time of a simulation in milliseconds\n"
+         << "\t--sim-tokens N\t- maximum number of tokens in a simulated net\n"
+         << "\t\t\t  (0 means no limit)\n"
+         << "\t--threads N\t- number of threads serving connections\n"
+         << "\t--queue N\t- number of connections waiting for a thread\n"
+         << "\t--sessions N\t- maximum number of simulations open on server\n"
+         << "\t--session-ttl S\t- seconds after an idle simulation is closed\n"
+         << "\t\t\t  (0 means never)\n"
+         << "\t--net-cache MB\t- memory for compiled nets (0 disables)\n"
+         << "\t--pack\t\t- store project versions in one pack file\n"
+         << "\t--simlog-interval MS\t- delay of simulation log writes\n"
+         << "\t\t\t  (0 writes each simulation at once)\n"
+         << "\t--reach-memory MB\t- memory for states of a reachability\n"
+         << "\t\t\t  analysis (0 means no limit)\n";
 }
 
+/**
+ * \brief Obsluha SIGTERM a SIGINT - ziadost o korektne ukoncenie servru.
+ * \param sig Cislo signalu.
+ */
 void sig_catcher(int sig) {
-    std::cout << "\rSignal catched: " << sig << std::endl;
-    throw 0;
+    (void) sig;
+    server2012_stop();
+}
+
+/**
+ * \brief Spracuje ciselny parameter.
+ * \param value Vysledna hodnota parametru.
+ * \param argc Pocet argumentov z prikazoveho riadku.
+ * \param argv Vektor argumentov z priklazoveho riadku.
+ * \param i Index prepinaca, posunie sa na jeho hodnotu.
+ * \retval true pri spravnom parametri.
+ */
+bool parse_number(unsigned & value, int argc, char * argv[], int & i) {
+    char * nptr;
+    const char * option = argv[i];
+
+    ++i;
+    if (i >= argc) {
+        std::cerr << "Option '" << option << "' requires an option!\n";
+        return false;
+    }
+    value = strtoul(argv[i], &nptr, 10);
+    if (! nptr || *nptr != '\0') {
+        std::cerr << "Bad number for option '" << option << "'!\n";
+        return false;
+    }
+
+    return true;
 }
 
 /**
@@ -70,6 +120,7 @@ void sig_catcher(int sig) {
 bool parse_param(Param & p, int argc, char * argv[]) {
     char * nptr;
     p.help = false; p.port = 0; p.userdb = 0;
+    p.config = server_default_config();
 
     for (int i = 1; i < argc; ++i) {
         if (! strcmp(argv[i], "-h")) {
@@ -101,6 +152,50 @@ bool parse_param(Param & p, int argc, char * argv[]) {
                 return false;
             }
             p.projectdb = argv[i];
+        } else if (! strcmp(argv[i], "--sim-steps")) {
+            if (! parse_number(p.config.budget.steps, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--sim-time")) {
+            if (! parse_number(p.config.budget.time, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--sim-tokens")) {
+            if (! parse_number(p.config.budget.tokens, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--threads")) {
+            if (! parse_number(p.config.threads, argc, argv, i))
+                return false;
+            if (p.config.threads == 0) {
+                std::cerr << "At least one thread is required!\n";
+                return false;
+            }
+        } else if (! strcmp(argv[i], "--queue")) {
+            if (! parse_number(p.config.queue, argc, argv, i))
+                return false;
+            if (p.config.queue == 0) {
+                std::cerr << "Queue size must be at least one!\n";
+                return false;
+            }
+        } else if (! strcmp(argv[i], "--sessions")) {
+            if (! parse_number(p.config.sessions, argc, argv, i))
+                return false;
+            if (p.config.sessions == 0) {
+                std::cerr << "At least one session is required!\n";
+                return false;
+            }
+        } else if (! strcmp(argv[i], "--session-ttl")) {
+            if (! parse_number(p.config.session_ttl, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--net-cache")) {
+            if (! parse_number(p.config.net_cache, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--pack")) {
+            p.config.pack = true;
+        } else if (! strcmp(argv[i], "--simlog-interval")) {
+            if (! parse_number(p.config.simlog_interval, argc, argv, i))
+                return false;
+        } else if (! strcmp(argv[i], "--reach-memory")) {
+            if (! parse_number(p.config.reach_memory, argc, argv, i))
+                return false;
         } else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             return false;
@@ -134,18 +229,15 @@ int main(int argc, char * argv[]) {
 
     try {
 
-        QApplication a(argc, argv);
+        QCoreApplication a(argc, argv);
         // Hlavna smycka serveru.
-        server2012(p.port, p.userdb, p.projectdb);
+        server2012(p.port, p.userdb, p.projectdb, p.config);
 
     }
     catch (const char * what) {
         std::cout << "> FATAL ERROR: " << what << std::endl;
         return EXIT_FAILURE;
     }
-    catch (int num) {
-        return num;
-    }
 
     return EXIT_SUCCESS;
 }
@@ -17,12 +17,24 @@
 
 const unsigned MSG_TIMEOUT = 30000;
 const unsigned MSG_BUFSIZE = 512;
+const qint64 MSG_FRAME_LIMIT = 64 * 1024 * 1024; //!< Najvacsie telo ramca.
 
 const char * MSG_ERR_MALFORMED   = "Malformed request!";
 const char * MSG_ERR_DUPLICIT    = "Duplicit option!";
 const char * MSG_ERR_REQUEST     = "Unknown request!";
 const char * MSG_ERR_CHECK       = "Request check failed!";
 const char * MSG_ERR_PREMATURE   = "Premature end of message! (Timeout ?!)";
+const char * MSG_ERR_LARGE       = "Request too large!";
+
+/**
+ * \brief Precitanie cisla v poradi bajtov siete z ramca.
+ * \param ptr Data ramca.
+ * \return Cislo (32 b).
+ */
+static quint32 msg_get32(const uchar * ptr) {
+    return (quint32(ptr[0]) << 24) | (quint32(ptr[1]) << 16)
+           | (quint32(ptr[2]) << 8) | quint32(ptr[3]);
+}
 
 /**
  * \brief Konstruktor rozparsovanej spravy.
@@ -31,6 +43,17 @@ Message::Message() {
     my_type = REQ_NULL;
     my_version = 0;
     my_version_stated = false;
+    my_steps = 0;
+    my_timeout = 0;
+    my_tokens = 0;
+    my_keep = false;
+    my_delta = false;
+    my_from = 0;
+    my_to = 0;
+    my_offset = 0;
+    my_limit = 0;
+    my_stats = false;
+    my_memory = 0;
 }
 
 /**
@@ -94,14 +117,120 @@ const QString & Message::desc() const {
 }
 
 /**
- * \brief Zaslane XML data projektu.
+ * \brief Zaslane XML data projektu v povodnom kodovani, bez prevodu na
+ * QString.
  * \return XML projektu.
- * \retval const QString & XML dokumentu.
+ * \retval const QByteArray & XML dokumentu.
  */
-const QString & Message::xml() const {
+const QByteArray & Message::xml() const {
     return my_xml;
 }
 
+/**
+ * \brief Limit poctu krokov simulacie zadany v poziadavku.
+ * \return Pocet krokov, 0 ak limit nebol zadany.
+ */
+unsigned Message::steps() const {
+    return my_steps;
+}
+
+/**
+ * \brief Limit casu simulacie zadany v poziadavku.
+ * \return Cas v milisekundach, 0 ak limit nebol zadany.
+ */
+unsigned Message::timeout() const {
+    return my_timeout;
+}
+
+/**
+ * \brief Limit poctu tokenov v sieti zadany v poziadavku.
+ * \return Pocet tokenov, 0 ak limit nebol zadany.
+ */
+unsigned Message::tokens() const {
+    return my_tokens;
+}
+
+/**
+ * \brief Informacia, ci klient ziada udrzanie spojenia pre dalsie poziadavky.
+ * \return true, ak poziadavok obsahoval polozku KEEP.
+ */
+bool Message::keep() const {
+    return my_keep;
+}
+
+/**
+ * \brief Identifikator simulacie otvorenej na serveri poziadavkom OPEN.
+ * \return Identifikator, prazdny ak nebol zadany.
+ */
+const QString & Message::session() const {
+    return my_session;
+}
+
+/**
+ * \brief Informacia, ci klient ziada ako vysledok simulacie len zmeny siete.
+ * \return true, ak poziadavok obsahoval polozku DELTA.
+ */
+bool Message::delta() const {
+    return my_delta;
+}
+
+/**
+ * \brief Spristupnenie najskorsieho casu zaznamov logu simulacii.
+ * \return Cas, 0 ak nebol zadany.
+ */
+unsigned Message::from() const {
+    return my_from;
+}
+
+/**
+ * \brief Spristupnenie najneskorsieho casu zaznamov logu simulacii.
+ * \return Cas, 0 ak nebol zadany.
+ */
+unsigned Message::to() const {
+    return my_to;
+}
+
+/**
+ * \brief Spristupnenie poctu preskocenych zaznamov logu simulacii.
+ * \return Pocet zaznamov, 0 ak nebol zadany.
+ */
+unsigned Message::offset() const {
+    return my_offset;
+}
+
+/**
+ * \brief Spristupnenie najvacsieho poctu zaznamov logu simulacii.
+ * \return Pocet zaznamov, 0 ak nebol zadany.
+ */
+unsigned Message::limit() const {
+    return my_limit;
+}
+
+/**
+ * \brief Predikat pre ziadost o suhrn simulacii uzivatelov.
+ * \return true, ak poziadavok obsahoval polozku STATS.
+ */
+bool Message::stats() const {
+    return my_stats;
+}
+
+/**
+ * \brief Zmeny pociatocneho znackovania pre jednotlive simulacie poziadavku
+ * BATCH v poradi poloziek MARKING.
+ * \return Zmeny znackovania, prazdna zmena ponecha pociatocne znackovanie.
+ */
+const QStringList & Message::markings() const {
+    return my_markings;
+}
+
+/**
+ * \brief Spristupnenie pamate pre stavy analyzy dosiahnutelnosti.
+ * \return Pamat v MiB, 0 ak nebola zadana.
+ */
+unsigned Message::memory() const {
+    return my_memory;
+}
+
 /**
  * \brief Pokial metoda parse() vrati false, metodou error() je mozne
  *        spristupnit popis chyby.
@@ -122,8 +251,13 @@ bool Message::socket(QTcpSocket * socket) {
     Q_ASSERT(socket);
 
     bool rv;
+    char first;
 
-    rv = this->parse(socket);
+    // Ramec binarneho protokolu sa rozozna podla prveho znaku.
+    if (socket->peek(&first, 1) == 1 && first == PROTO_FRAME_MAGIC)
+        rv = this->parse_frame(socket);
+    else
+        rv = this->parse(socket);
     // Ak funkcia parse_line naplnila chybovu hlasku, doslo k chybe.
     if (! my_error.isEmpty()) {
         return false;
@@ -150,7 +284,6 @@ bool Message::socket(QTcpSocket * socket) {
 bool Message::parse(QTcpSocket * socket) {
     Q_ASSERT(socket);
 
-    bool xml_line = false;
     my_xml.clear();
     QByteArray line, tmp;
 
@@ -162,11 +295,27 @@ bool Message::parse(QTcpSocket * socket) {
 
         if (! qstrcmp(line.data(), PROTO_END)) {
             return true;
-        } else if (xml_line) {
-            line.replace("\r\n", "\n");
-            my_xml.append(line);
         } else if (! qstrcmp(line.data(), PROTOH_XML)) {
-            xml_line = true;
+            // XML data su posledne, koncia prazdnym riadkom.
+            return this->parse_xml(socket);
+        } else if (! qstrcmp(line.data(), PROTOH_DELTA)) {
+            if (my_delta) {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
+            my_delta = true;
+        } else if (! qstrcmp(line.data(), PROTOH_STATS)) {
+            if (my_stats) {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
+            my_stats = true;
+        } else if (! qstrcmp(line.data(), PROTOH_KEEP)) {
+            if (my_keep) {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
+            my_keep = true;
         } else if (! qstrncmp(line.data(), PROTOH_PN, qstrlen(PROTOH_PN))) {
             if (my_username.isEmpty()) {
                 line.replace("\r\n", "\0");
@@ -191,6 +340,15 @@ bool Message::parse(QTcpSocket * socket) {
                 my_error = MSG_ERR_DUPLICIT;
                 return false;
             }
+        } else if (! qstrncmp(line.data(), PROTOH_SESSION,
+                              qstrlen(PROTOH_SESSION))) {
+            if (my_session.isEmpty()) {
+                line.replace("\r\n", "\0");
+                my_session = line.mid(qstrlen(PROTOH_SESSION));
+            } else {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
         } else if (! qstrncmp(line.data(), PROTOH_DESC, qstrlen(PROTOH_DESC))) {
             if (my_desc.isEmpty()) {
                 line.replace("\r\n", "\0");
@@ -211,6 +369,51 @@ bool Message::parse(QTcpSocket * socket) {
             qstrlen(line.data()) - qstrlen(PROTOH_VERSION) - qstrlen(PROTO_EOL));
             my_version = tmp.toUInt();
             my_version_stated = true;
+        } else if (! qstrncmp(line.data(), PROTOH_STEPS,
+                              qstrlen(PROTOH_STEPS))) {
+            if (! this->parse_limit(line, PROTOH_STEPS, my_steps))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_TIMEOUT,
+                              qstrlen(PROTOH_TIMEOUT))) {
+            if (! this->parse_limit(line, PROTOH_TIMEOUT, my_timeout))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_TOKENS,
+                              qstrlen(PROTOH_TOKENS))) {
+            if (! this->parse_limit(line, PROTOH_TOKENS, my_tokens))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_FROM, qstrlen(PROTOH_FROM))) {
+            if (! this->parse_limit(line, PROTOH_FROM, my_from))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_TO, qstrlen(PROTOH_TO))) {
+            if (! this->parse_limit(line, PROTOH_TO, my_to))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_OFFSET,
+                              qstrlen(PROTOH_OFFSET))) {
+            if (! this->parse_limit(line, PROTOH_OFFSET, my_offset))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_LIMIT,
+                              qstrlen(PROTOH_LIMIT))) {
+            if (! this->parse_limit(line, PROTOH_LIMIT, my_limit))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_MEMORY,
+                              qstrlen(PROTOH_MEMORY))) {
+            if (! this->parse_limit(line, PROTOH_MEMORY, my_memory))
+                return false;
+        } else if (! qstrncmp(line.data(), PROTOH_MARKING,
+                              qstrlen(PROTOH_MARKING))) {
+            // Polozka sa opakuje a moze byt dlhsia ako buffer riadku.
+            tmp = line.constData();
+            while (! tmp.endsWith(PROTO_EOL)) {
+                if (! socket->canReadLine()
+                        && ! socket->waitForReadyRead(MSG_TIMEOUT)) {
+                    my_error = MSG_ERR_PREMATURE;
+                    return false;
+                }
+                tmp.append(socket->readLine());
+            }
+            tmp.chop(qstrlen(PROTO_EOL));
+            my_markings.push_back(
+                QString::fromAscii(tmp.mid(qstrlen(PROTOH_MARKING))));
         } else if (! qstrncmp(line.data(), PROTOH_DO, qstrlen(PROTOH_DO))) {
             if (my_type == REQ_NULL) {
                 QByteArray tmp = line.mid(qstrlen(PROTOH_DO));
@@ -233,6 +436,301 @@ bool Message::parse(QTcpSocket * socket) {
     return false;
 }
 
+/**
+ * \brief Nacitanie XML dat textoveho poziadavku az po prazdny riadok, ktorym
+ * poziadavok konci. Data sa citaju po blokoch, ktore socket prave ma, bez
+ * delenia na riadky; za koncom poziadavku sa necita, moze nasledovat dalsi
+ * poziadavok. Konce riadkov \r\n sa nahradia \n naraz po nacitani.
+ * \param socket Socket, z ktoreho sa data citaju.
+ * \return false ak data neprisli vcas, je nastavena my_error.
+ */
+bool Message::parse_xml(QTcpSocket * socket) {
+    Q_ASSERT(socket);
+
+    // Koniec posledneho riadku XML a prazdny riadok.
+    const QByteArray end = QByteArray("\n") + PROTO_END;
+    QByteArray tail, chunk;
+    int pos;
+
+    for (;;) {
+        if (socket->bytesAvailable() == 0
+            && ! socket->waitForReadyRead(MSG_TIMEOUT)) {
+            my_error = MSG_ERR_PREMATURE;
+            return false;
+        }
+
+        // Koniec moze zacinat v uz nacitanych datach, XML zacina na
+        // zaciatku riadku.
+        tail = my_xml.right(end.size() - 1);
+        if (tail.size() < end.size() - 1)
+            tail.prepend('\n');
+        chunk = socket->peek(socket->bytesAvailable());
+        pos = (tail + chunk).indexOf(end);
+
+        if (pos >= 0) {
+            my_xml.append(socket->read(pos + end.size() - tail.size()));
+            break;
+        }
+        my_xml.append(socket->read(chunk.size()));
+    }
+
+    my_xml.chop(qstrlen(PROTO_END));
+    if (my_xml.contains('\r'))
+        my_xml.replace("\r\n", "\n");
+
+    return true;
+}
+
+/**
+ * \brief Spracovanie ramca binarneho protokolu. Hlavicka ramca urcuje dlzku
+ * poloziek aj tela, ramec je preto nacitany naraz bez hladania koncov riadkov.
+ * \param socket Socket z ktoreho sa ramec nacita.
+ * \return Informacia o spravnosti ramca, pri chybe je nastavena my_error.
+ */
+bool Message::parse_frame(QTcpSocket * socket) {
+    Q_ASSERT(socket);
+
+    QByteArray head, fields;
+    const uchar * ptr;
+    qint64 fields_len, body_len;
+    int pos, len;
+    int field;
+
+    if (! this->read_exact(socket, head, PROTO_FRAME_HEAD))
+        return false;
+
+    ptr = reinterpret_cast<const uchar *>(head.constData());
+    fields_len = (ptr[2] << 8) | ptr[3];
+    body_len = msg_get32(ptr + 4);
+
+    if (body_len > MSG_FRAME_LIMIT) {
+        my_error = MSG_ERR_LARGE;
+        return false;
+    }
+
+    if (! this->read_exact(socket, fields, fields_len))
+        return false;
+
+    ptr = reinterpret_cast<const uchar *>(fields.constData());
+    for (pos = 0; pos < fields_len; pos += len) {
+        if (pos + 3 > fields_len) {
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+        }
+
+        field = ptr[pos];
+        len = (ptr[pos + 1] << 8) | ptr[pos + 2];
+        pos += 3;
+
+        if (pos + len > fields_len) {
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+        }
+
+        if (! this->parse_field(field, fields.mid(pos, len)))
+            return false;
+    }
+
+    // Telo sa cita priamo zo socketu, dalej sa uz nekopiruje ani neprevadza.
+    return this->read_exact(socket, my_xml, body_len);
+}
+
+/**
+ * \brief Spracovanie jednej polozky ramca binarneho protokolu.
+ * \param field Znacka polozky (enum Proto_field).
+ * \param value Hodnota polozky.
+ * \return Informacia o spravnosti polozky, pri chybe je nastavena my_error.
+ */
+bool Message::parse_field(int field, const QByteArray & value) {
+    const uchar * ptr = reinterpret_cast<const uchar *>(value.constData());
+    QString * str = 0;
+    unsigned * num = 0;
+    bool * flag = 0;
+
+    switch (field) {
+        case FIELD_PN:
+            str = &my_username;
+            break;
+
+        case FIELD_PASS:
+            str = &my_password;
+            break;
+
+        case FIELD_NAME:
+            str = &my_project;
+            break;
+
+        case FIELD_DESC:
+            str = &my_desc;
+            break;
+
+        case FIELD_SESSION:
+            str = &my_session;
+            break;
+
+        case FIELD_STEPS:
+            num = &my_steps;
+            break;
+
+        case FIELD_TIMEOUT:
+            num = &my_timeout;
+            break;
+
+        case FIELD_TOKENS:
+            num = &my_tokens;
+            break;
+
+        case FIELD_KEEP:
+            flag = &my_keep;
+            break;
+
+        case FIELD_DELTA:
+            flag = &my_delta;
+            break;
+
+        case FIELD_FROM:
+            num = &my_from;
+            break;
+
+        case FIELD_TO:
+            num = &my_to;
+            break;
+
+        case FIELD_OFFSET:
+            num = &my_offset;
+            break;
+
+        case FIELD_LIMIT:
+            num = &my_limit;
+            break;
+
+        case FIELD_STATS:
+            flag = &my_stats;
+            break;
+
+        case FIELD_MEMORY:
+            num = &my_memory;
+            break;
+
+        case FIELD_MARKING:
+            // Polozka sa moze opakovat, kazda je jedna simulacia.
+            my_markings.push_back(
+                QString::fromAscii(value.constData(), value.size()));
+            return true;
+
+        case FIELD_VERSION:
+            if (my_version_stated) {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
+            if (value.size() != 4) {
+                my_error = MSG_ERR_MALFORMED;
+                return false;
+            }
+            my_version = msg_get32(ptr);
+            my_version_stated = true;
+            return true;
+
+        case FIELD_DO:
+            if (my_type != REQ_NULL) {
+                my_error = MSG_ERR_DUPLICIT;
+                return false;
+            }
+            my_type = proto_byte2reqt(value + PROTO_EOL);
+            if (my_type == REQ_NULL) {
+                my_error = MSG_ERR_REQUEST;
+                return false;
+            }
+            return true;
+
+        default:
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+    }
+
+    if (str) {
+        if (! str->isEmpty()) {
+            my_error = MSG_ERR_DUPLICIT;
+            return false;
+        }
+        *str = QString::fromAscii(value.constData(), value.size());
+    } else if (num) {
+        if (*num != 0) {
+            my_error = MSG_ERR_DUPLICIT;
+            return false;
+        }
+        if (value.size() != 4) {
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+        }
+        *num = msg_get32(ptr);
+        // Rovnako ako v textovom poziadavku, nulovy limit nie je platny.
+        if (*num == 0) {
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+        }
+    } else {
+        if (*flag) {
+            my_error = MSG_ERR_DUPLICIT;
+            return false;
+        }
+        if (! value.isEmpty()) {
+            my_error = MSG_ERR_MALFORMED;
+            return false;
+        }
+        *flag = true;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Nacitanie zadaneho poctu bajtov zo socketu, na chybajuce data sa caka.
+ * \param socket Socket.
+ * \param data Nacitane data.
+ * \param size Pocet bajtov.
+ * \return false ak data neprisli vcas, je nastavena my_error.
+ */
+bool Message::read_exact(QTcpSocket * socket, QByteArray & data, qint64 size) {
+    while (socket->bytesAvailable() < size) {
+        if (! socket->waitForReadyRead(MSG_TIMEOUT)) {
+            my_error = MSG_ERR_PREMATURE;
+            return false;
+        }
+    }
+
+    data = socket->read(size);
+    return true;
+}
+
+/**
+ * \brief Spracovanie riadku s nenulovym cislom - limitom simulacie alebo
+ * dotazom na log simulacii.
+ * \param line Riadok poziadavku.
+ * \param header Hlavicka limitu.
+ * \param value Hodnota limitu, musi byt nulova (limit este nebol zadany).
+ * \return Informacia o spravnosti riadku, pri chybe je nastavena my_error.
+ */
+bool Message::parse_limit(const QByteArray & line, const char * header,
+                          unsigned & value) {
+    bool ok;
+
+    if (value != 0) {
+        my_error = MSG_ERR_DUPLICIT;
+        return false;
+    }
+
+    value = line.mid(qstrlen(header),
+            qstrlen(line.data()) - qstrlen(header) - qstrlen(PROTO_EOL))
+            .toUInt(&ok);
+    if (! ok || value == 0) {
+        my_error = MSG_ERR_MALFORMED;
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * \brief Metoda volana pri rozparsovani poziadavku, skontroluje uplnost
  *        poziadavku.
@@ -247,6 +745,49 @@ bool Message::check() {
         return false;
     }
 
+    // Limity simulacie a format vysledku je mozne zadat len pri simulacii,
+    // cas a pamat aj pri analyze dosiahnutelnosti.
+    if (my_type != REQ_STEP && my_type != REQ_RUN && my_type != REQ_BATCH
+            && (my_steps != 0 || my_tokens != 0)) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+    if (my_type != REQ_STEP && my_type != REQ_RUN && my_type != REQ_BATCH
+            && my_type != REQ_REACH && my_timeout != 0) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+    if (my_type != REQ_REACH && my_memory != 0) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+    if (my_type != REQ_STEP && my_type != REQ_RUN && my_delta) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+
+    // Zmeny znackovania je mozne zadat len pri suborovej simulacii.
+    if (my_type != REQ_BATCH && ! my_markings.isEmpty()) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+
+    // Dotaz na cast logu je mozne zadat len pri SIMLOG.
+    if (my_type != REQ_SIMLOG
+            && (my_from != 0 || my_to != 0 || my_offset != 0 || my_limit != 0
+                || my_stats)) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+
+    // Identifikator simulacie je mozne zadat len pri poziadavkoch na otvorenu
+    // simulaciu.
+    if (! my_session.isEmpty() && my_type != REQ_STEP && my_type != REQ_RUN
+            && my_type != REQ_RESET && my_type != REQ_CLOSE) {
+        my_error = MSG_ERR_CHECK;
+        return false;
+    }
+
     switch (my_type) {
         case REQ_REGISTER:
             /* WALKTHRU */
@@ -340,8 +881,42 @@ bool Message::check() {
         case REQ_STEP:
             /* WALKTHRU */
         case REQ_RUN:
-            // Poziadavky, ktore musia byt vyplnene.
-            if (my_xml.isEmpty()) {
+            // Poziadavky, ktore musia byt vyplnene - siet alebo otvorena
+            // simulacia, nie oboje.
+            if (my_xml.isEmpty() == my_session.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+
+            // Poziadavky ktore nesmu byt vyplnene.
+            if (! my_desc.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+            break;
+
+        case REQ_OPEN:
+            // Poziadavky, ktore musia byt vyplnene - siet alebo projekt na
+            // serveri.
+            if (my_xml.isEmpty()
+                && (my_project.isEmpty() || ! my_version_stated)) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+
+            // Poziadavky ktore nesmu byt vyplnene.
+            if (! my_desc.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+            break;
+
+        case REQ_BATCH:
+            // Poziadavky, ktore musia byt vyplnene - aspon jedna simulacia a
+            // siet alebo projekt na serveri.
+            if (my_markings.isEmpty()
+                || (my_xml.isEmpty()
+                    && (my_project.isEmpty() || ! my_version_stated))) {
                 my_error = MSG_ERR_CHECK;
                 return false;
             }
@@ -353,6 +928,41 @@ bool Message::check() {
             }
             break;
 
+        case REQ_REACH:
+            // Poziadavky, ktore musia byt vyplnene - siet alebo projekt na
+            // serveri.
+            if (my_xml.isEmpty()
+                && (my_project.isEmpty() || ! my_version_stated)) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+
+            // Poziadavky ktore nesmu byt vyplnene.
+            if (! my_desc.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+            break;
+
+        case REQ_RESET:
+            /* WALKTHRU */
+        case REQ_CLOSE:
+            // Poziadavky, ktore musia byt vyplnene.
+            if (my_session.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+
+            // Poziadavky ktore nesmu byt vyplnene.
+            if (! my_project.isEmpty()
+                || ! my_desc.isEmpty()
+                || my_version_stated
+                || ! my_xml.isEmpty()) {
+                my_error = MSG_ERR_CHECK;
+                return false;
+            }
+            break;
+
         case REQ_NULL:
             /* WALKTHRU */
         default:
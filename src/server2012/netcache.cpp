@@ -0,0 +1,87 @@
+/**
+ * \file     netcache.cpp
+ * \brief    Vyrovnavacia pamat prelozenych sieti zdielana vlaknami servru.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 14 2012
+ */
+
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QCryptographicHash>
+
+#include <pn/server/simnet.h>
+#include <pn/server/netcache.h>
+
+/**
+ * \brief Konstruktor.
+ * \param capacity Kapacita v MiB, 0 vypne ukladanie sieti.
+ */
+NetCache::NetCache(unsigned capacity) {
+    my_nets.setMaxCost(capacity * 1024);
+}
+
+/**
+ * \brief Destruktor. Siete, ktore este niektora simulacia pouziva, zostanu
+ * platne az do jej ukoncenia.
+ */
+NetCache::~NetCache() {
+}
+
+/**
+ * \brief Vyhladanie prelozenej siete.
+ * \param key Kluc siete, project_key() alebo xml_key().
+ * \return Siet, prazdny ukazatel ak siet nie je ulozena.
+ */
+SimNetPtr NetCache::find(const QString & key) {
+    SimNetPtr rv;
+
+    my_mutex.lock();
+
+    // QCache::object() zaroven oznaci siet ako naposledy pouzitu.
+    SimNetPtr * net = my_nets.object(key);
+    if (net)
+        rv = *net;
+
+    my_mutex.unlock();
+
+    return rv;
+}
+
+/**
+ * \brief Ulozenie prelozenej siete.
+ * \param key Kluc siete, project_key() alebo xml_key().
+ * \param net Prelozena siet.
+ * \param size Velkost XML siete v bajtoch.
+ */
+void NetCache::insert(const QString & key, const SimNetPtr & net, int size) {
+    my_mutex.lock();
+
+    // Siet vacsia ako cela kapacita QCache neulozi a ukazatel uvolni.
+    my_nets.insert(key, new SimNetPtr(net), size / 1024 + 1);
+
+    my_mutex.unlock();
+}
+
+/**
+ * \brief Kluc siete projektu ulozeneho na serveri. Verzie projektu sa
+ * nemenia, kluc preto netreba zneplatnovat.
+ * \param project Nazov projektu.
+ * \param version Verzia projektu.
+ * \return Kluc siete.
+ */
+QString NetCache::project_key(const QString & project, unsigned version) {
+    return project + '/' + QString::number(version);
+}
+
+/**
+ * \brief Kluc siete zaslanej v poziadavku.
+ * \param xml XML siete.
+ * \return Kluc siete.
+ */
+QString NetCache::xml_key(const QByteArray & xml) {
+    return QString("sha1:")
+           + QCryptographicHash::hash(xml, QCryptographicHash::Sha1).toHex();
+}
@@ -6,12 +6,29 @@
  * \date     feb 26 2012
  */
 
+#include <cstring>
+
 #include <QString>
 #include <QStringList>
 #include <QFile>
 #include <QDir>
-#include <QTextStream>
 #include <QDateTime>
+#include <QMap>
+#include <QVector>
+#include <QReadWriteLock>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QDataStream>
+#include <QBuffer>
+#include <QHash>
+#include <QList>
+#include <QCache>
+#include <QMutex>
+#include <QtAlgorithms>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 
 #include <pn/server/projectdb.h>
 
@@ -24,20 +41,567 @@ const char * PROJECTDB_ERR_MKDIR_VER  = "Failed to create directory for project"
 const char * PROJECTDB_XML_FILE       = "project.xml";
 const char * PROJECTDB_DESC_FILE      = "desc.txt";
 const char * PROJECTDB_USER_FILE      = "author.txt";
-const char * PROJECTDB_SLOG_FILE      = "simlog.txt";
+const char * PROJECTDB_SLOG_FILE      = "simlog.bin";
+const char * PROJECTDB_SLOG_TEXT      = "simlog.txt";
 const char * PROJECTDB_SLOG_SEPARATOR = ":";
+const char * PROJECTDB_PACK_FILE      = "project.pack";
+
+/**
+ * \brief Kazda PROJECTDB_SNAPSHOT-ta verzia je v project.pack ulozena cela,
+ * zostavenie verzie tak aplikuje najviac PROJECTDB_SNAPSHOT - 1 rozdielov.
+ */
+const unsigned PROJECTDB_SNAPSHOT     = 16;
+
+/**
+ * \brief Velkost pamate zostavenych XML verzii v KiB.
+ */
+const int PROJECTDB_XML_CACHE         = 32 * 1024;
+
+/**
+ * \brief Dlzka bloku, podla ktoreho sa v predchadzajucej verzii hladaju
+ * zhodne useky XML.
+ */
+const int PROJECTDB_DELTA_BLOCK       = 32;
+
+/**
+ * \brief Typy zaznamov v project.pack. Kazdy zaznam zacina typom (quint8),
+ * cislom verzie (quint32), casom (quint32) a menom uzivatela (QByteArray v
+ * UTF-8). Zaznam verzie dalej obsahuje popis (QByteArray v UTF-8), dlzku dat
+ * (quint32) a samotne XML, pri PACK_DELTA rozdiel oproti predchadzajucej
+ * verzii skomprimovany pomocou qCompress(). Zaznam simulacie uz nic.
+ */
+enum ProjectDB_record {
+    PACK_VERSION = 1,       //!< Nova verzia projektu, cele XML.
+    PACK_SIMLOG  = 2,       //!< Simulacia verzie projektu.
+    PACK_DELTA   = 3        //!< Nova verzia projektu, rozdiel XML.
+};
+
+/**
+ * \brief Typy zaznamov v simlog.bin. SIMLOG_USER (meno ako QByteArray v UTF-8)
+ * zavadza uzivatela, ktory dostane dalsie poradove cislo. SIMLOG_RUN (cas a
+ * cislo uzivatela, quint32) je jedna simulacia.
+ */
+enum ProjectDB_simlog {
+    SIMLOG_USER = 'U',
+    SIMLOG_RUN  = 'S'
+};
+
+/**
+ * \brief Operacie rozdielu XML. Rozdiel je postupnost operacii, DELTA_COPY
+ * (pozicia a dlzka, quint32) skopiruje usek predchadzajucej verzie, DELTA_INSERT
+ * (dlzka, quint32, a data) vlozi nove data.
+ */
+enum ProjectDB_delta {
+    DELTA_COPY   = 'C',
+    DELTA_INSERT = 'I'
+};
+
+/**
+ * \brief Zapisanie dat suboru az na disk.
+ * \param file Otvoreny subor.
+ * \return Informacia o uspesnosti zapisu.
+ */
+static bool file_sync(QFile & file) {
+    if (! file.flush())
+        return false;
+#ifdef Q_OS_UNIX
+    return ::fsync(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+/**
+ * \brief Zapisanie cisla do rozdielu v big endian.
+ * \param delta Rozdiel.
+ * \param value Cislo.
+ */
+static void delta_put(QByteArray & delta, quint32 value) {
+    delta.append(static_cast<char>(value >> 24));
+    delta.append(static_cast<char>(value >> 16));
+    delta.append(static_cast<char>(value >> 8));
+    delta.append(static_cast<char>(value));
+}
+
+/**
+ * \brief Precitanie cisla z rozdielu v big endian.
+ * \param ptr Data rozdielu.
+ * \return Cislo.
+ */
+static quint32 delta_get(const char * ptr) {
+    const uchar * data = reinterpret_cast<const uchar *>(ptr);
+
+    return (quint32(data[0]) << 24) | (quint32(data[1]) << 16)
+           | (quint32(data[2]) << 8) | quint32(data[3]);
+}
+
+/**
+ * \brief Zapisanie operacie DELTA_INSERT, ak su nejake data.
+ * \param delta Rozdiel.
+ * \param data Vkladane data.
+ * \param size Dlzka vkladanych dat.
+ */
+static void delta_insert(QByteArray & delta, const char * data, int size) {
+    if (size <= 0)
+        return;
+
+    delta.append(static_cast<char>(DELTA_INSERT));
+    delta_put(delta, size);
+    delta.append(data, size);
+}
+
+/**
+ * \brief Vypocet rozdielu novej verzie XML oproti predchadzajucej. Zaciatky
+ * blokov predchadzajucej verzie sa zaindexuju podla hashu a nova verzia sa
+ * prechadza po bajtoch. Pri zhode bloku sa zhodny usek rozsiri na obe strany a
+ * zapise ako DELTA_COPY, ostatne data ako DELTA_INSERT.
+ * \param base Predchadzajuca verzia.
+ * \param target Nova verzia.
+ * \return Rozdiel.
+ */
+static QByteArray delta_make(const QByteArray & base, const QByteArray & target) {
+    const char * b = base.constData();
+    const char * t = target.constData();
+    const int block = PROJECTDB_DELTA_BLOCK;
+    QHash<uint, int> blocks;
+    QHash<uint, int>::const_iterator it;
+    QByteArray delta;
+    int pos = 0, lit = 0, from, len;
+    uint hash;
+
+    for (int off = 0; off + block <= base.size(); off += block) {
+        hash = qHash(QByteArray::fromRawData(b + off, block));
+        if (! blocks.contains(hash))
+            blocks.insert(hash, off);
+    }
+
+    while (pos + block <= target.size()) {
+        it = blocks.constFind(qHash(QByteArray::fromRawData(t + pos, block)));
+        if (it == blocks.constEnd() || memcmp(b + *it, t + pos, block)) {
+            ++pos;
+            continue;
+        }
+
+        from = *it;
+        len = block;
+        while (pos > lit && from > 0 && b[from - 1] == t[pos - 1]) {
+            --pos; --from; ++len;
+        }
+        while (from + len < base.size() && pos + len < target.size()
+               && b[from + len] == t[pos + len])
+            ++len;
+
+        delta_insert(delta, t + lit, pos - lit);
+        delta.append(static_cast<char>(DELTA_COPY));
+        delta_put(delta, from);
+        delta_put(delta, len);
+
+        pos += len;
+        lit = pos;
+    }
+
+    delta_insert(delta, t + lit, target.size() - lit);
+    return delta;
+}
+
+/**
+ * \brief Zostavenie novej verzie XML z predchadzajucej verzie a rozdielu.
+ * \param base Predchadzajuca verzia.
+ * \param delta Rozdiel vytvoreny pomocou delta_make().
+ * \param target Nova verzia (vystupny parameter).
+ * \return false ak je rozdiel poskodeny.
+ */
+static bool delta_apply(const QByteArray & base, const QByteArray & delta,
+                        QByteArray & target) {
+    const char * ptr = delta.constData();
+    const char * end = ptr + delta.size();
+    quint32 from, len;
+
+    target.clear();
+
+    while (ptr < end) {
+        if (*ptr == DELTA_COPY && end - ptr >= 9) {
+            from = delta_get(ptr + 1);
+            len = delta_get(ptr + 5);
+            ptr += 9;
+            if (from > static_cast<quint32>(base.size())
+                || len > base.size() - from)
+                return false;
+            target.append(base.constData() + from, len);
+        } else if (*ptr == DELTA_INSERT && end - ptr >= 5) {
+            len = delta_get(ptr + 1);
+            ptr += 5;
+            if (len > static_cast<quint32>(end - ptr))
+                return false;
+            target.append(ptr, len);
+            ptr += len;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
 
 /**
  * \brief Konstruktor pre databazu projektov.
  * \param dir Umiestnenie adresara databazy projektov.
+ * \param pack Verzie ukladat do project.pack namiesto adresarov verzii.
  * \throws const char * Pokial zadany adresar nie je platny.
  */
-ProjectDB::ProjectDB(const QString & dir) {
+ProjectDB::ProjectDB(const QString & dir, bool pack) {
     my_pdir = dir;
+    my_pack = pack;
     my_error = 0;
+    my_xml_cache.setMaxCost(PROJECTDB_XML_CACHE);
 
     if (! my_pdir.exists())
         throw "Bad direcotry for projectdb";
+
+    this->load();
+}
+
+/**
+ * \brief Nacitanie zoznamu projektov a udajov o ich verziach do pamate.
+ * Verzie projektu su v podadresaroch 1 az N, alebo v project.pack.
+ * \throws const char * Pokial pri project.pack databaza obsahuje projekt
+ * s verziami v podadresaroch - tie by boli nedostupne.
+ */
+void ProjectDB::load() {
+    QStringList projects;
+    QString line;
+    Version ver;
+    int sep;
+
+    projects = my_pdir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    foreach (const QString & pname, projects) {
+        QDir proj(my_pdir.filePath(pname));
+        unsigned count = proj.entryList(QDir::Dirs | QDir::NoDotAndDotDot)
+                         .count();
+
+        if (my_pack) {
+            // Projekt bez project.pack nema ziadnu verziu (napr. po pade servru
+            // pri pridani), verzie v podadresaroch sa neprevadzaju.
+            if (! proj.exists(PROJECTDB_PACK_FILE)) {
+                if (count != 0)
+                    throw "Projectdb has version directories, cannot use --pack";
+                continue;
+            }
+            this->load_pack(pname, my_index[pname]);
+            continue;
+        }
+
+        QVector<Version> & versions = my_index[pname];
+
+        for (unsigned v = 1; v <= count; ++v) {
+            ver.desc = first_line(this->path(pname, v, PROJECTDB_DESC_FILE));
+
+            line = first_line(this->path(pname, v, PROJECTDB_USER_FILE));
+            sep = line.indexOf(PROJECTDB_SLOG_SEPARATOR);
+            ver.user = line.mid(0, sep);
+            ver.time = line.mid(sep + 1).toUInt();
+            ver.offset = ver.size = 0;
+            ver.delta = false;
+            // Log simulacii sa nacita az pri prvom pouziti.
+            ver.simlog.loaded = false;
+
+            versions.push_back(ver);
+        }
+    }
+}
+
+/**
+ * \brief Nacitanie zaznamov z project.pack. XML sa nenacitava, zapamata sa len
+ * jeho pozicia. Neuplny zaznam na konci suboru (napr. po pade servru pocas
+ * zapisu) je odrezany.
+ * \param pname Nazov projektu.
+ * \param versions Verzie projektu (vystupny parameter).
+ */
+void ProjectDB::load_pack(const QString & pname, QVector<Version> & versions) {
+    QFile pack(my_pdir.filePath(pname + '/' + PROJECTDB_PACK_FILE));
+    QDataStream in(&pack);
+    QByteArray user, desc;
+    qint64 good = 0;
+    quint32 version, time, size;
+    quint8 type;
+    quint32 id;
+    Version ver;
+
+    ver.simlog.loaded = true;
+
+    if (! pack.open(QIODevice::ReadOnly))
+        return;
+
+    while (! in.atEnd()) {
+        in >> type >> version >> time >> user;
+        if (in.status() != QDataStream::Ok)
+            break;
+
+        if (type == PACK_VERSION || type == PACK_DELTA) {
+            in >> desc >> size;
+            if (in.status() != QDataStream::Ok
+                || version != static_cast<unsigned>(versions.size()) + 1
+                || (type == PACK_DELTA && version == 1))
+                break;
+
+            ver.offset = pack.pos();
+            ver.size = size;
+            ver.delta = type == PACK_DELTA;
+            if (in.skipRawData(size) != static_cast<int>(size))
+                break;
+
+            ver.user = QString::fromUtf8(user);
+            ver.time = time;
+            ver.desc = QString::fromUtf8(desc);
+            versions.push_back(ver);
+        } else if (type == PACK_SIMLOG) {
+            if (version < 1 || version > static_cast<unsigned>(versions.size()))
+                break;
+
+            unsigned t = time;
+            simlog_add(versions[version - 1].simlog, t,
+                       QString::fromUtf8(user), id);
+        } else {
+            break;
+        }
+
+        good = pack.pos();
+    }
+
+    if (good < pack.size()) {
+        pack.close();
+        QFile::resize(pack.fileName(), good);
+    }
+}
+
+/**
+ * \brief Pripojenie zaznamu na koniec project.pack. Zaznam je zapisany cely
+ * alebo vobec. Volat so zamknutym my_lock na zapis.
+ * \param pname Nazov projektu.
+ * \param record Zaznam.
+ * \return Pozicia zaznamu v subore, -1 pri chybe.
+ */
+qint64 ProjectDB::append_pack(const QString & pname,
+                              const QByteArray & record) {
+    QFile pack(my_pdir.filePath(pname + '/' + PROJECTDB_PACK_FILE));
+    qint64 end;
+
+    if (! pack.open(QIODevice::Append)) {
+        my_error = PROJECTDB_ERR_WOPEN;
+        return -1;
+    }
+
+    end = pack.size();
+    if (pack.write(record) != record.size() || ! file_sync(pack)) {
+        pack.resize(end);
+        my_error = PROJECTDB_ERR_WOPEN;
+        return -1;
+    }
+
+    pack.close();
+    return end;
+}
+
+/**
+ * \brief Vytvorenie novej verzie projektu v project.pack. Verzia je ulozena
+ * ako komprimovany rozdiel oproti predchadzajucej verzii, cele XML sa uklada
+ * pre prvu a kazdu PROJECTDB_SNAPSHOT-tu verziu a vtedy, ked rozdiel nie je
+ * vyrazne mensi ako XML. Volat so zamknutym my_lock na zapis.
+ * \param pname Nazov projektu, adresar projektu uz musi existovat.
+ * \param user  Nazov uzivatela, ktory zadanu verziu vytvoril.
+ * \param desc  Popis novej verzie.
+ * \param xml   XML data danej verzie.
+ * \return Cislo novej verzie, 0 pri chybe.
+ */
+unsigned ProjectDB::add_pack(const QString & pname, const QString & user,
+                             const QString & desc, const QByteArray & xml) {
+    unsigned version = my_index.value(pname).size() + 1;
+    QByteArray record, data, base;
+    QBuffer buffer(&record);
+    QDataStream out(&buffer);
+    qint64 pos;
+    Version ver;
+
+    // XML je rovnako ako v project.xml ukoncene novym riadkom.
+    QByteArray full(xml);
+    full.append('\n');
+
+    ver.user = user;
+    ver.desc = desc;
+    ver.time = QDateTime::currentDateTime().toTime_t();
+    ver.simlog.loaded = true;
+    ver.delta = (version - 1) % PROJECTDB_SNAPSHOT != 0
+                && this->pack_xml(base, pname, version - 1);
+
+    if (ver.delta) {
+        data = qCompress(delta_make(base, full));
+        ver.delta = data.size() < full.size() / 2;
+    }
+    if (! ver.delta)
+        data = full;
+    ver.size = data.size();
+
+    buffer.open(QIODevice::WriteOnly);
+    out << static_cast<quint8>(ver.delta ? PACK_DELTA : PACK_VERSION)
+        << static_cast<quint32>(version) << static_cast<quint32>(ver.time)
+        << user.toUtf8() << desc.toUtf8() << static_cast<quint32>(ver.size);
+    out.writeRawData(data.constData(), data.size());
+    buffer.close();
+
+    pos = this->append_pack(pname, record);
+    if (pos < 0)
+        return 0;
+
+    ver.offset = pos + record.size() - ver.size;
+    my_index[pname].push_back(ver);
+
+    // Nova verzia sa casto hned stahuje, netreba ju potom zostavovat.
+    this->cache_xml(full, pname, version);
+    return version;
+}
+
+/**
+ * \brief Zostavenie XML verzie projektu z project.pack. Od pozadovanej verzie
+ * sa hlada spat najblizsia verzia ulozena cela alebo uz zostavena v pamati a
+ * na nu sa postupne aplikuju rozdiely. Volat so zamknutym my_lock.
+ * \param xml Zostavene XML (vystupny parameter).
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu.
+ * \return Informacia o uspesnosti prevedenia poziadavku.
+ */
+bool ProjectDB::pack_xml(QByteArray & xml, const QString & pname,
+                         unsigned version) {
+    QMap<QString, QVector<Version> >::const_iterator it;
+    QFile pack(my_pdir.filePath(pname + '/' + PROJECTDB_PACK_FILE));
+    QList<unsigned> deltas;
+    QByteArray data, next;
+    unsigned v = version;
+
+    xml.clear();
+
+    it = my_index.constFind(pname);
+    if (it == my_index.constEnd()
+        || version < 1 || version > static_cast<unsigned>(it->size())) {
+        my_error = PROJECTDB_ERR_UNVER;
+        return false;
+    }
+
+    if (! pack.open(QIODevice::ReadOnly)) {
+        my_error = PROJECTDB_ERR_ROPEN;
+        return false;
+    }
+
+    // Prva verzia je vzdy ulozena cela, cyklus preto skonci.
+    while (! this->cached_xml(xml, pname, v)) {
+        const Version & ver = it->at(v - 1);
+        if (! ver.delta) {
+            if (! pack.seek(ver.offset)) {
+                my_error = PROJECTDB_ERR_ROPEN;
+                return false;
+            }
+            xml = pack.read(ver.size);
+            if (xml.size() != ver.size) {
+                my_error = PROJECTDB_ERR_ROPEN;
+                return false;
+            }
+            break;
+        }
+        deltas.prepend(v--);
+    }
+
+    foreach (unsigned d, deltas) {
+        const Version & ver = it->at(d - 1);
+        if (! pack.seek(ver.offset)) {
+            my_error = PROJECTDB_ERR_ROPEN;
+            return false;
+        }
+        data = qUncompress(pack.read(ver.size));
+        if (! delta_apply(xml, data, next)) {
+            my_error = PROJECTDB_ERR_ROPEN;
+            return false;
+        }
+        xml = next;
+    }
+
+    pack.close();
+
+    if (! deltas.isEmpty())
+        this->cache_xml(xml, pname, version);
+    return true;
+}
+
+/**
+ * \brief Vyhladanie zostaveneho XML verzie v pamati.
+ * \param xml XML verzie (vystupny parameter).
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu.
+ * \return true ak bolo XML najdene.
+ */
+bool ProjectDB::cached_xml(QByteArray & xml, const QString & pname,
+                           unsigned version) {
+    bool found;
+
+    my_cache_mutex.lock();
+
+    QByteArray * data = my_xml_cache.object(pname + '/'
+                                            + QString::number(version));
+    found = data != 0;
+    if (found)
+        xml = *data;
+
+    my_cache_mutex.unlock();
+
+    return found;
+}
+
+/**
+ * \brief Ulozenie zostaveneho XML verzie do pamate.
+ * \param xml XML verzie.
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu.
+ */
+void ProjectDB::cache_xml(const QByteArray & xml, const QString & pname,
+                          unsigned version) {
+    my_cache_mutex.lock();
+
+    my_xml_cache.insert(pname + '/' + QString::number(version),
+                        new QByteArray(xml), xml.size() / 1024 + 1);
+
+    my_cache_mutex.unlock();
+}
+
+/**
+ * \brief Cesta k suboru verzie projektu.
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu.
+ * \param file Nazov suboru verzie.
+ * \return Cesta k suboru.
+ */
+QString ProjectDB::path(const QString & pname, unsigned version,
+                        const char * file) const {
+    return my_pdir.filePath(pname + '/' + QString::number(version) + '/'
+                            + file);
+}
+
+/**
+ * \brief Nacitanie prveho riadku suboru.
+ * \param path Cesta k suboru.
+ * \return Prvy riadok bez znaku noveho riadku, prazdny ak subor nie je mozne
+ * citat.
+ */
+QString ProjectDB::first_line(const QString & path) {
+    QFile data(path);
+    QString line;
+
+    if (! data.open(QIODevice::ReadOnly))
+        return line;
+
+    char buf;
+    while (data.getChar(&buf) && buf != '\n')
+        line.append(buf);
+
+    data.close();
+    return line;
 }
 
 /**
@@ -53,13 +617,10 @@ ProjectDB::~ProjectDB() {
  * \retval true v pripade projekt existuje.
  */
 bool ProjectDB::exist(const QString & pname) {
-    my_error = 0;
-    QDir proj(my_pdir.path());
+    QReadLocker lock(&my_lock);
 
-    if (! proj.cd(pname))
-        return false;
-    else
-        return true;
+    my_error = 0;
+    return my_index.contains(pname);
 }
 
 /**
@@ -70,16 +631,11 @@ bool ProjectDB::exist(const QString & pname) {
  * \retval true v pripade projekt existuje v danej verzii.
  */
 bool ProjectDB::exist(const QString & pname, unsigned version) {
-    my_error = 0;
-    QDir proj(my_pdir.path());
-
-    if (! proj.cd(pname))
-        return false;
+    QReadLocker lock(&my_lock);
 
-    if (! proj.cd(QString::number(version)))
-        return false;
-
-    return true;
+    my_error = 0;
+    return version >= 1
+           && version <= static_cast<unsigned>(my_index.value(pname).size());
 }
 
 /**
@@ -90,37 +646,101 @@ bool ProjectDB::exist(const QString & pname, unsigned version) {
  * \return Informacia o uspesnosti prevedenia poziadavku.
  * \retval V pripade uspechu true, v opacnom pripade false.
  */
-bool ProjectDB::xml_data(QString & xml,
+bool ProjectDB::xml_data(QByteArray & xml,
                          const QString & pname,
                          unsigned version) {
     my_error = 0;
-            my_error = PROJECTDB_ERR_MKDIR_PROJ;
     xml.clear();
-    QDir proj(my_pdir.path());
 
-    if (! proj.cd(pname)) {
-        my_error = PROJECTDB_ERR_UNPROJ;
-        return false;
+    if (my_pack) {
+        QReadLocker lock(&my_lock);
+        return this->pack_xml(xml, pname, version);
     }
 
-    if (! proj.cd(QString::number(version))) {
+    if (! this->exist(pname, version)) {
         my_error = PROJECTDB_ERR_UNVER;
         return false;
     }
 
-    QFile data(proj.absoluteFilePath(PROJECTDB_XML_FILE));
+    QFile data;
+    qint64 size;
+    bool delta;
+    const uchar * ptr = this->map_xml(data, size, delta, pname, version);
 
-    if (! data.open(QIODevice::ReadOnly)) {
-        my_error = PROJECTDB_ERR_ROPEN;
+    if (! ptr)
         return false;
-    }
 
-    xml = data.readAll();
+    xml = QByteArray(reinterpret_cast<const char *>(ptr), size);
 
+    data.unmap(const_cast<uchar *>(ptr));
     data.close();
     return true;
 }
 
+/**
+ * \brief Namapovanie ulozenych XML dat projektu v danej verzii do pamate bez
+ * ich kopirovania. Po pouziti je nutne data uvolnit pomocou file.unmap().
+ * Verziu ulozenu ako rozdiel namapovat nie je mozne, vtedy je vratena 0,
+ * nastaveny priznak delta a XML je nutne ziskat pomocou xml_data().
+ * \param file Subor, z ktoreho su data namapovane (vystupny parameter).
+ * \param size Velkost XML dat (vystupny parameter).
+ * \param delta Verzia je ulozena ako rozdiel (vystupny parameter).
+ * \param pname Nazov projektu pre spristupnenie dat.
+ * \param version Cislo verzie projektu.
+ * \return Namapovane XML data, 0 pri chybe.
+ */
+const uchar * ProjectDB::map_xml(QFile & file, qint64 & size, bool & delta,
+                                 const QString & pname, unsigned version) {
+    QMap<QString, QVector<Version> >::const_iterator it;
+    qint64 offset = 0;
+    uchar * ptr;
+
+    my_error = 0;
+    size = 0;
+    delta = false;
+
+    my_lock.lockForRead();
+    it = my_index.constFind(pname);
+    if (it == my_index.constEnd()
+        || version < 1 || version > static_cast<unsigned>(it->size())) {
+        my_lock.unlock();
+        my_error = PROJECTDB_ERR_UNVER;
+        return 0;
+    }
+
+    if (my_pack) {
+        if (it->at(version - 1).delta) {
+            my_lock.unlock();
+            delta = true;
+            return 0;
+        }
+        // Zaznamy v project.pack sa len pridavaju, pozicia XML sa nemeni.
+        offset = it->at(version - 1).offset;
+        size = it->at(version - 1).size;
+        file.setFileName(my_pdir.filePath(pname + '/' + PROJECTDB_PACK_FILE));
+    } else {
+        file.setFileName(this->path(pname, version, PROJECTDB_XML_FILE));
+    }
+    my_lock.unlock();
+
+    if (! file.open(QIODevice::ReadOnly)) {
+        my_error = PROJECTDB_ERR_ROPEN;
+        return 0;
+    }
+
+    if (! my_pack)
+        size = file.size();
+
+    ptr = file.map(offset, size);
+    if (! ptr) {
+        my_error = PROJECTDB_ERR_ROPEN;
+        file.close();
+        return 0;
+    }
+
+    return ptr;
+}
+
 /**
  * \brief Spristupnenie popisu danej verzie projektu.
  * \param desc Spristupneny popis projektu.
@@ -130,32 +750,24 @@ bool ProjectDB::xml_data(QString & xml,
  * \retval V pripade uspechu true, v opacnom pripade false.
  */
 bool ProjectDB::desc(QString & desc, const QString & pname, unsigned version) {
+    QReadLocker lock(&my_lock);
+    QMap<QString, QVector<Version> >::const_iterator it;
+
     my_error = 0;
     desc.clear();
-    QDir proj(my_pdir.path());
 
-    if (! proj.cd(pname)) {
+    it = my_index.constFind(pname);
+    if (it == my_index.constEnd()) {
         my_error = PROJECTDB_ERR_UNPROJ;
         return false;
     }
 
-    if (! proj.cd(QString::number(version))) {
+    if (version < 1 || version > static_cast<unsigned>(it->size())) {
         my_error = PROJECTDB_ERR_UNVER;
         return false;
     }
 
-    QFile data(proj.absoluteFilePath(PROJECTDB_DESC_FILE));
-
-    if (! data.open(QIODevice::ReadOnly)) {
-        my_error = PROJECTDB_ERR_ROPEN;
-        return false;
-    }
-
-    char buf;
-    while (data.getChar(&buf) && buf != '\n')
-        desc.append(buf);
-
-    data.close();
+    desc = it->at(version - 1).desc;
     return true;
 }
 
@@ -170,35 +782,25 @@ bool ProjectDB::desc(QString & desc, const QString & pname, unsigned version) {
  */
 bool ProjectDB::user(QString & username, unsigned & time,
                      const QString & pname, unsigned version) {
+    QReadLocker lock(&my_lock);
+    QMap<QString, QVector<Version> >::const_iterator it;
+
     my_error = 0;
     username.clear();
-    QDir proj(my_pdir.path());
 
-    if (! proj.cd(pname)) {
+    it = my_index.constFind(pname);
+    if (it == my_index.constEnd()) {
         my_error = PROJECTDB_ERR_UNPROJ;
         return false;
     }
 
-    if (! proj.cd(QString::number(version))) {
+    if (version < 1 || version > static_cast<unsigned>(it->size())) {
         my_error = PROJECTDB_ERR_UNVER;
         return false;
     }
 
-    QFile data(proj.absoluteFilePath(PROJECTDB_USER_FILE));
-
-    if (! data.open(QIODevice::ReadOnly)) {
-        my_error = PROJECTDB_ERR_ROPEN;
-        return false;
-    }
-
-    char buf;
-    while (data.getChar(&buf) && buf != '\n')
-        username.append(buf);
-
-    time = username.mid(username.indexOf(PROJECTDB_SLOG_SEPARATOR) + 1).toUInt();
-    username = username.mid(0, username.indexOf(PROJECTDB_SLOG_SEPARATOR));
-
-    data.close();
+    username = it->at(version - 1).user;
+    time = it->at(version - 1).time;
     return true;
 }
 
@@ -215,11 +817,16 @@ bool ProjectDB::user(QString & username, unsigned & time,
 unsigned ProjectDB::add_project(const QString & pname,
                                 const QString & user,
                                 const QString & desc,
-                                const QString & xml) {
+                                const QByteArray & xml) {
+    // Zapis drzi zamok az do zaradenia verzie do pamate, aby dve nove verzie
+    // nedostali rovnake cislo.
+    QWriteLocker lock(&my_lock);
+
     my_error = 0;
     QDir proj(my_pdir.path());
-    unsigned version = this->version_count(pname) + 1;
-    QString version_file = QString::number(version);
+    unsigned version;
+    QString version_file;
+    Version ver;
 
     if (! proj.cd(pname)) {
         if (! proj.mkdir(pname)) {
@@ -232,6 +839,12 @@ unsigned ProjectDB::add_project(const QString & pname,
         }
     }
 
+    if (my_pack)
+        return this->add_pack(pname, user, desc, xml);
+
+    version = my_index.value(pname).size() + 1;
+    version_file = QString::number(version);
+
     if (! proj.mkdir(version_file)) {
         my_error = PROJECTDB_ERR_MKDIR_VER;
         return 0;
@@ -256,7 +869,8 @@ unsigned ProjectDB::add_project(const QString & pname,
         return 0;
     }
 
-    QString time = QString::number(QDateTime::currentDateTime().toTime_t());
+    ver.time = QDateTime::currentDateTime().toTime_t();
+    QString time = QString::number(ver.time);
 
     f_desc.write(desc.toAscii().data(), desc.length());
     f_desc.putChar('\n');
@@ -264,11 +878,18 @@ unsigned ProjectDB::add_project(const QString & pname,
     f_user.write(PROJECTDB_SLOG_SEPARATOR, qstrlen(PROJECTDB_SLOG_SEPARATOR));
     f_user.write(time.toAscii().data(), time.length());
     f_user.putChar('\n');
-    f_xml.write(xml.toAscii().data(), xml.length());
+    f_xml.write(xml);
     f_xml.putChar('\n');
 
     f_desc.close(); f_user.close(); f_xml.close(); f_slog.close();
 
+    ver.user = user;
+    ver.desc = desc;
+    ver.offset = ver.size = 0;
+    ver.delta = false;
+    ver.simlog.loaded = true;
+    my_index[pname].push_back(ver);
+
     return version;
 }
 
@@ -289,89 +910,367 @@ const QString ProjectDB::error() const {
  * \retval V pripade uspechu true, v opacnom pripade false.
  */
 bool ProjectDB::projects(QStringList & projects) {
+    QReadLocker lock(&my_lock);
+
     my_error = 0;
-    projects = my_pdir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    projects = my_index.keys();
     return true;
 }
 
 /**
- * \brief Zaznamenianie simulacie na strane servru.
- * \param username Meno pouzivatela, ktory odsimuloval projekt.
- * \param pname Nazov projektu, ktory bol odsimulovany.
- * \param version Cislo verzie, ktora bola simulovana.
- * \return Pokial pozadovany projekt v danej verzii neexistuje false ako aj v
- * pripade, ze nebolo mozne pridat zaznam do logu.
- * \retval false v pripade chyby, inac true.
+ * \brief Pridanie simulacie do logu v pamati. Cas, ktory by porusil poradie
+ * zaznamov (napr. po posunuti hodin), je nahradeny casom posledneho zaznamu.
+ * \param log Log simulacii verzie.
+ * \param time Cas simulacie, moze byt upraveny.
+ * \param username Uzivatel, ktory simuloval.
+ * \param id Poradove cislo uzivatela v logu (vystupny parameter).
+ * \return true ak uzivatel v logu este nebol.
  */
-bool ProjectDB::update_simlog(const QString & username,
-                              const QString & pname,
-                              unsigned version) {
-    QDir proj(my_pdir.path());
+bool ProjectDB::simlog_add(Simlog & log, unsigned & time,
+                           const QString & username, quint32 & id) {
+    QHash<QString, quint32>::const_iterator it = log.ids.constFind(username);
+    bool added = it == log.ids.constEnd();
 
-    if (! proj.cd(pname)) {
-        my_error = PROJECTDB_ERR_UNPROJ;
-        return false;
+    if (! log.times.isEmpty() && time < log.times.last())
+        time = log.times.last();
+
+    if (added) {
+        SimlogUser user;
+        user.username = username;
+        user.count = 0;
+        id = log.stats.size();
+        log.ids.insert(username, id);
+        log.stats.push_back(user);
+    } else {
+        id = *it;
     }
-    if (! proj.cd(QString::number(version))) {
-        my_error = PROJECTDB_ERR_UNVER;
-        return false;
+
+    SimlogUser & user = log.stats[id];
+    if (user.count++ == 0)
+        user.first = time;
+    user.last = time;
+
+    log.times.push_back(time);
+    log.users.push_back(id);
+    return added;
+}
+
+/**
+ * \brief Pridanie simulacie do logu v pamati a zostavenie jej zaznamu pre
+ * simlog.bin.
+ * \param data Zaznamy pre simlog.bin, zaznam sa pripoji na koniec.
+ * \param log Log simulacii verzie.
+ * \param time Cas simulacie.
+ * \param username Uzivatel, ktory simuloval.
+ */
+void ProjectDB::simlog_record(QByteArray & data, Simlog & log, unsigned time,
+                              const QString & username) {
+    QBuffer buffer(&data);
+    QDataStream out(&buffer);
+    quint32 id;
+
+    buffer.open(QIODevice::Append);
+    if (simlog_add(log, time, username, id))
+        out << static_cast<quint8>(SIMLOG_USER) << username.toUtf8();
+    out << static_cast<quint8>(SIMLOG_RUN) << static_cast<quint32>(time) << id;
+    buffer.close();
+}
+
+/**
+ * \brief Nacitanie logu simulacii verzie zo simlog.bin. Ak simlog.bin este
+ * neexistuje, je vytvoreny z textoveho simlog.txt. Neuplny zaznam na konci
+ * suboru je odrezany. Volat so zamknutym my_lock na zapis.
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu.
+ * \param log Log simulacii verzie (vystupny parameter).
+ * \return Informacia o uspesnosti nacitania.
+ */
+bool ProjectDB::load_simlog(const QString & pname, unsigned version,
+                            Simlog & log) {
+    QFile f_slog(this->path(pname, version, PROJECTDB_SLOG_FILE));
+    QDataStream in(&f_slog);
+    QByteArray name, data;
+    quint32 time, id;
+    quint8 type;
+    qint64 good = 0;
+    unsigned t;
+    int pos;
+
+    log = Simlog();
+    log.loaded = true;
+
+    if (! f_slog.exists()) {
+        QFile f_text(this->path(pname, version, PROJECTDB_SLOG_TEXT));
+        if (f_text.open(QIODevice::ReadOnly)) {
+            while (! f_text.atEnd()) {
+                name = f_text.readLine().trimmed();
+                pos = name.indexOf(PROJECTDB_SLOG_SEPARATOR);
+                if (pos < 0)
+                    continue;
+                simlog_record(data, log, name.left(pos).toUInt(),
+                              QString::fromUtf8(name.mid(pos + 1)));
+            }
+            f_text.close();
+        }
+
+        if (! f_slog.open(QIODevice::WriteOnly)
+            || f_slog.write(data) != data.size() || ! file_sync(f_slog)) {
+            my_error = PROJECTDB_ERR_WOPEN;
+            log.loaded = false;
+            return false;
+        }
+        return true;
     }
 
-    QFile f_slog(proj.absoluteFilePath(PROJECTDB_SLOG_FILE));
-    if (! f_slog.open(QIODevice::Append)) {
-        my_error = PROJECTDB_ERR_WOPEN;
+    if (! f_slog.open(QIODevice::ReadOnly)) {
+        my_error = PROJECTDB_ERR_ROPEN;
+        log.loaded = false;
         return false;
     }
 
-    QTextStream log(&f_slog);
-    log << QDateTime::currentDateTime().toTime_t()
-        << PROJECTDB_SLOG_SEPARATOR << username << '\n';
-    f_slog.close();
+    while (! in.atEnd()) {
+        in >> type;
+        if (type == SIMLOG_USER) {
+            in >> name;
+            if (in.status() != QDataStream::Ok)
+                break;
+            SimlogUser user;
+            user.username = QString::fromUtf8(name);
+            user.count = user.first = user.last = 0;
+            log.ids.insert(user.username, log.stats.size());
+            log.stats.push_back(user);
+        } else if (type == SIMLOG_RUN) {
+            in >> time >> id;
+            if (in.status() != QDataStream::Ok
+                || id >= static_cast<quint32>(log.stats.size()))
+                break;
+            t = time;
+            simlog_add(log, t, log.stats.at(id).username, id);
+        } else {
+            break;
+        }
+
+        good = f_slog.pos();
+    }
+
+    if (good < f_slog.size()) {
+        f_slog.close();
+        QFile::resize(f_slog.fileName(), good);
+    }
+
     return true;
 }
 
 /**
- * \brief Rozparsovanie suboru s informaciami o simulaciach do zoznamu.
+ * \brief Nacitanie logu simulacii verzie do pamate, ak este nacitany nie je.
+ * \param pname Nazov projektu.
+ * \param version Cislo verzie projektu, musi existovat.
+ * \return Informacia o uspesnosti nacitania.
+ */
+bool ProjectDB::ensure_simlog(const QString & pname, unsigned version) {
+    {
+        QReadLocker lock(&my_lock);
+        if (my_index.value(pname).at(version - 1).simlog.loaded)
+            return true;
+    }
+
+    QWriteLocker lock(&my_lock);
+    Simlog & log = my_index[pname][version - 1].simlog;
+
+    return log.loaded || this->load_simlog(pname, version, log);
+}
+
+/**
+ * \brief Zaznamenanie davky simulacii na strane servru. Log kazdej verzie
+ * (alebo project.pack) sa otvori raz pre celu davku a po zapise sa data
+ * zapisu na disk.
+ * \param records Zaznamy simulacii v poradi, v akom nastali.
+ * \return Pokial niektory projekt v danej verzii neexistuje false ako aj v
+ * pripade, ze nebolo mozne pridat zaznam do logu. Ostatne zaznamy su zapisane.
+ * \retval false v pripade chyby, inac true.
+ */
+bool ProjectDB::update_simlog(const QList<SimlogRecord> & records) {
+    QMap<QString, QVector<Version> >::iterator it;
+    QMap<QString, QByteArray> logs;
+    QMap<QString, Simlog *> owners;
+    QMap<QString, QByteArray>::const_iterator lit;
+    bool rv = true;
+
+    if (my_pack)
+        return this->update_pack_simlog(records);
+
+    QWriteLocker lock(&my_lock);
+
+    my_error = 0;
+
+    foreach (const SimlogRecord & rec, records) {
+        it = my_index.find(rec.project);
+        if (it == my_index.end() || rec.version < 1
+            || rec.version > static_cast<unsigned>(it->size())) {
+            my_error = PROJECTDB_ERR_UNVER;
+            rv = false;
+            continue;
+        }
+
+        Simlog & log = (*it)[rec.version - 1].simlog;
+        if (! log.loaded && ! this->load_simlog(rec.project, rec.version, log)) {
+            rv = false;
+            continue;
+        }
+
+        QString file = this->path(rec.project, rec.version,
+                                  PROJECTDB_SLOG_FILE);
+        simlog_record(logs[file], log, rec.time, rec.username);
+        owners.insert(file, &log);
+    }
+
+    for (lit = logs.constBegin(); lit != logs.constEnd(); ++lit) {
+        QFile f_slog(lit.key());
+        if (! f_slog.open(QIODevice::Append)
+            || f_slog.write(lit.value()) != lit.value().size()
+            || ! file_sync(f_slog)) {
+            my_error = PROJECTDB_ERR_WOPEN;
+            rv = false;
+            // Log v pamati sa pri dalsom pouziti znovu nacita z disku.
+            Simlog * log = owners.value(lit.key());
+            *log = Simlog();
+            log->loaded = false;
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * \brief Zaznamenanie davky simulacii do project.pack. Zaznamy jedneho
+ * projektu sa pripoja naraz.
+ * \param records Zaznamy simulacii v poradi, v akom nastali.
+ * \retval false v pripade chyby, inac true.
+ */
+bool ProjectDB::update_pack_simlog(const QList<SimlogRecord> & records) {
+    QWriteLocker lock(&my_lock);
+    QMap<QString, QVector<Version> >::iterator it;
+    QMap<QString, QByteArray> packs;
+    QMap<QString, QByteArray>::const_iterator pit;
+    QMap<QString, QList<SimlogRecord> > added;
+    bool rv = true;
+    quint32 id;
+    unsigned time;
+
+    my_error = 0;
+
+    foreach (const SimlogRecord & rec, records) {
+        it = my_index.find(rec.project);
+        if (it == my_index.end() || rec.version < 1
+            || rec.version > static_cast<unsigned>(it->size())) {
+            my_error = PROJECTDB_ERR_UNVER;
+            rv = false;
+            continue;
+        }
+
+        QBuffer buffer(&packs[rec.project]);
+        QDataStream out(&buffer);
+        buffer.open(QIODevice::Append);
+        out << static_cast<quint8>(PACK_SIMLOG)
+            << static_cast<quint32>(rec.version)
+            << static_cast<quint32>(rec.time) << rec.username.toUtf8();
+        buffer.close();
+
+        added[rec.project].push_back(rec);
+    }
+
+    for (pit = packs.constBegin(); pit != packs.constEnd(); ++pit) {
+        if (this->append_pack(pit.key(), pit.value()) < 0) {
+            rv = false;
+            continue;
+        }
+
+        QVector<Version> & versions = my_index[pit.key()];
+        foreach (const SimlogRecord & rec, added.value(pit.key())) {
+            time = rec.time;
+            simlog_add(versions[rec.version - 1].simlog, time, rec.username,
+                       id);
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * \brief Spristupnenie casti logu simulacii verzie projektu. Zaznamy v
+ * casovom rozsahu dotazu sa najdu binarnym vyhladavanim v zoradenych casoch.
  * \param log Vystupny parameter - naplneny zoznam TIME, USER pre kazdy
  * zaznam
- * \param pname Nazov projektu, pre ktory sa ma subor s informaciami o simulacii
- * rozparsovat
+ * \param total Pocet zaznamov v casovom rozsahu pred aplikovanim offset a
+ * limit (vystupny parameter).
+ * \param pname Nazov projektu.
  * \param version Verzia projektu projektu.
+ * \param query Dotaz na cast logu.
  * \retval false v pripade, ze projekt v danej verzii neexistuje alebo nie je
  * mozne citat data.
- * \return Informacia o uspesnom otvoreni suboru a rozparsovani.
+ * \return Informacia o uspesnom spristupneni logu.
  */
-bool ProjectDB::simlog(QStringList & log,
-                       const QString & pname,
-                       unsigned & version) {
-    QDir proj(my_pdir.path());
+bool ProjectDB::simlog(QStringList & log, unsigned & total,
+                       const QString & pname, unsigned version,
+                       const SimlogQuery & query) {
+    QVector<quint32>::const_iterator first, last;
+    int begin, end;
 
-    if (! proj.cd(pname)) {
-        my_error = PROJECTDB_ERR_UNPROJ;
-        return false;
-    }
-    if (! proj.cd(QString::number(version))) {
+    log.clear();
+    total = 0;
+
+    if (! this->exist(pname, version)) {
         my_error = PROJECTDB_ERR_UNVER;
         return false;
     }
 
-    QFile f_slog(proj.absoluteFilePath(PROJECTDB_SLOG_FILE));
-    if (! f_slog.open(QIODevice::ReadOnly)) {
-        my_error = PROJECTDB_ERR_WOPEN;
+    if (! this->ensure_simlog(pname, version))
         return false;
+
+    QReadLocker lock(&my_lock);
+    const Simlog & data = my_index.constFind(pname)->at(version - 1).simlog;
+
+    first = qLowerBound(data.times.constBegin(), data.times.constEnd(),
+                        static_cast<quint32>(query.from));
+    last = query.to == 0 ? data.times.constEnd()
+                         : qUpperBound(first, data.times.constEnd(),
+                                       static_cast<quint32>(query.to));
+    total = last - first;
+
+    begin = first - data.times.constBegin() + qMin(query.offset, total);
+    end = last - data.times.constBegin();
+    if (query.limit != 0 && static_cast<unsigned>(end - begin) > query.limit)
+        end = begin + query.limit;
+
+    for (int i = begin; i < end; ++i) {
+        log << QString::number(data.times.at(i))
+            << data.stats.at(data.users.at(i)).username;
     }
 
-    int pos;
-    QByteArray line;
-    while (!  f_slog.atEnd()) {
-        line = f_slog.readLine();
-        pos = line.lastIndexOf(PROJECTDB_SLOG_SEPARATOR);
-        log << line.mid(0, pos);
-        // Musi sa odstranit znak noveho riadku.
-        log << line.mid(pos + 1, qstrlen(line.data()) - pos - 2);
+    return true;
+}
+
+/**
+ * \brief Spristupnenie suhrnu simulacii verzie projektu podla uzivatelov.
+ * \param users Suhrn simulacii uzivatelov v poradi ich prvej simulacie.
+ * \param pname Nazov projektu.
+ * \param version Verzia projektu projektu.
+ * \return Informacia o uspesnom spristupneni suhrnu.
+ */
+bool ProjectDB::simlog_users(QList<SimlogUser> & users, const QString & pname,
+                             unsigned version) {
+    users.clear();
+
+    if (! this->exist(pname, version)) {
+        my_error = PROJECTDB_ERR_UNVER;
+        return false;
     }
 
-    f_slog.close();
+    if (! this->ensure_simlog(pname, version))
+        return false;
+
+    QReadLocker lock(&my_lock);
+    users = my_index.constFind(pname)->at(version - 1).simlog.stats.toList();
     return true;
 }
 
@@ -382,11 +1281,9 @@ bool ProjectDB::simlog(QStringList & log,
  * \retval unsigned Pocet verzii pre zadany projekt.
  */
 unsigned ProjectDB::version_count(const QString & pname) {
-    my_error = 0;
-    QDir ver(my_pdir.path());
-    if (! ver.cd(pname))
-        return 0;
+    QReadLocker lock(&my_lock);
 
-    return ver.entryList(QDir::Dirs | QDir::NoDotAndDotDot).count();
+    my_error = 0;
+    return my_index.value(pname).size();
 }
 
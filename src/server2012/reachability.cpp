@@ -0,0 +1,252 @@
+/**
+ * \file     reachability.cpp
+ * \brief    Analyza dosiahnutelnych stavov petriho siete.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 20 2012
+ */
+
+#include <QVector>
+#include <QList>
+#include <QSet>
+#include <QQueue>
+#include <QString>
+#include <QByteArray>
+#include <QtAlgorithms>
+#include <QElapsedTimer>
+
+#include <cstring>
+
+#include <pn/server/simnet.h>
+#include <pn/server/simulation.h>
+#include <pn/server/reachability.h>
+
+const char * REACH_LIMIT_TIME   = "Time limit reached, state space is not finished";
+const char * REACH_LIMIT_MEMORY = "Memory limit reached, state space is not finished";
+
+/**
+ * Odhad rezie jedneho navstiveneho stavu v bajtoch (uzol QSet, hlavicka
+ * QByteArray, polozka fronty).
+ */
+const quint64 REACHABILITY_STATE_OVERHEAD = 64;
+/**
+ * Najvacsi pocet zaznamenanych mrtvych stavov.
+ */
+const int REACHABILITY_DEADLOCKS = 16;
+
+/**
+ * \brief Konstruktor.
+ * \param engine interpret vlakna pre vyrazy, ktore sa nepodarilo prelozit
+ */
+Reachability::Reachability(QScriptEngine * engine) : my_sim(engine) {
+    my_states = 0;
+    my_edges = 0;
+    my_deadlocks = 0;
+}
+
+/**
+ * \brief Destruktor.
+ */
+Reachability::~Reachability() {
+}
+
+/**
+ * \brief Kompaktny zapis znackovania - pre kazde miesto pocet tokenov a ich
+ * zoradene hodnoty. Rovnake znackovania maju rovnaky zapis.
+ * \param marking znackovanie, vsetky tokeny su aktivne
+ * \return zapis znackovania
+ */
+QByteArray Reachability::encode(const SimMarking & marking) {
+    QVector<int> data;
+
+    for (int p = 0; p < marking.size(); ++p) {
+        QVector<int> tokens = marking[p].active.values();
+        qSort(tokens);
+        data.push_back(tokens.size());
+        data += tokens;
+    }
+
+    return QByteArray(reinterpret_cast<const char *>(data.constData()),
+                      data.size() * sizeof(int));
+}
+
+/**
+ * \brief Obnovenie znackovania z kompaktneho zapisu (encode()).
+ * \param key zapis znackovania
+ * \param places pocet miest siete
+ * \return znackovanie s aktivnymi tokenmi
+ */
+SimMarking Reachability::decode(const QByteArray & key, int places) {
+    SimMarking marking(places);
+    const char * data = key.constData();
+    int value;
+
+    for (int p = 0; p < places; ++p) {
+        int count;
+        std::memcpy(&count, data, sizeof(int));
+        data += sizeof(int);
+        for (int i = 0; i < count; ++i) {
+            std::memcpy(&value, data, sizeof(int));
+            data += sizeof(int);
+            marking[p].active.add(value);
+        }
+    }
+
+    return marking;
+}
+
+/**
+ * \brief Prehladanie stavoveho priestoru siete z jej pociatocneho znackovania.
+ * Pri vycerpani limitu su vysledky ciastocne a limit() obsahuje jeho popis.
+ * \param net prelozena siet
+ * \param budget limity analyzy
+ * \return false pre indikaciu chyby pri simulacii prechodu
+ */
+bool Reachability::explore(const SimNetPtr & net,
+                           const ReachBudget & budget) {
+    QSet<QByteArray> visited;
+    QQueue<QByteArray> queue;
+    quint64 memory = quint64(budget.memory) * 1024 * 1024;
+    quint64 used = 0;
+    int places = net->place_count();
+    int transitions = net->transition_count();
+
+    SimBudget sb;
+    sb.steps = 0;
+    sb.time = budget.time;
+    sb.tokens = 0;
+
+    my_sim.set_parallel(false);
+    my_sim.set_budget(sb);
+    my_sim.prepare(net);
+
+    my_states = 0;
+    my_edges = 0;
+    my_deadlocks = 0;
+    my_bounds.fill(0, places);
+    my_deadlock_markings.clear();
+    my_limit.clear();
+    my_error.clear();
+    my_timer.start();
+
+    QByteArray initial = Reachability::encode(net->initial_marking());
+    visited.insert(initial);
+    queue.enqueue(initial);
+    used += initial.size() + REACHABILITY_STATE_OVERHEAD;
+    ++my_states;
+    for (int p = 0; p < places; ++p)
+        my_bounds[p] = net->initial_marking()[p].active.size();
+
+    while (! queue.isEmpty() && my_limit.isEmpty()) {
+        if (budget.time != 0 && my_timer.elapsed() > budget.time) {
+            my_limit = REACH_LIMIT_TIME;
+            break;
+        }
+
+        SimMarking marking = Reachability::decode(queue.dequeue(), places);
+        QList<SimMarking> next;
+        bool dead = true;
+
+        for (int t = 0; t < transitions && my_limit.isEmpty(); ++t) {
+            if (! my_sim.successors(marking, t, next)) {
+                if (! my_sim.error().isEmpty()) {
+                    my_error = my_sim.error();
+                    return false;
+                }
+                my_limit = REACH_LIMIT_TIME;
+                break;
+            }
+
+            for (int i = 0; i < next.size(); ++i) {
+                dead = false;
+                ++my_edges;
+
+                QByteArray key = Reachability::encode(next[i]);
+                if (visited.contains(key))
+                    continue;
+
+                // Novy stav sa uz nezmesti do pamate.
+                quint64 cost = key.size() + REACHABILITY_STATE_OVERHEAD;
+                if (memory != 0 && used + cost > memory) {
+                    my_limit = REACH_LIMIT_MEMORY;
+                    break;
+                }
+
+                visited.insert(key);
+                queue.enqueue(key);
+                used += cost;
+                ++my_states;
+                for (int p = 0; p < places; ++p) {
+                    my_bounds[p] = qMax(my_bounds[p],
+                                        next[i].at(p).active.size());
+                }
+            }
+        }
+
+        if (dead && my_limit.isEmpty()) {
+            ++my_deadlocks;
+            if (my_deadlock_markings.size() < REACHABILITY_DEADLOCKS)
+                my_deadlock_markings.push_back(marking);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * \brief Pocet najdenych dosiahnutelnych stavov vratane pociatocneho.
+ * \return pocet stavov
+ */
+unsigned Reachability::states() const {
+    return my_states;
+}
+
+/**
+ * \brief Pocet uskutocnenych prechodov medzi stavmi, kazde viazanie tokenov
+ * prechodu je jedna hrana.
+ * \return pocet hran grafu dosiahnutelnosti
+ */
+unsigned Reachability::edges() const {
+    return my_edges;
+}
+
+/**
+ * \brief Pocet preskumanych stavov, v ktorych nie je mozne uskutocnit ziadny
+ * prechod.
+ * \return pocet mrtvych stavov
+ */
+unsigned Reachability::deadlocks() const {
+    return my_deadlocks;
+}
+
+/**
+ * \brief Najvacsi pocet tokenov kazdeho miesta v najdenych stavoch.
+ * \return pocty tokenov podla indexu miesta
+ */
+const QVector<int> & Reachability::bounds() const {
+    return my_bounds;
+}
+
+/**
+ * \brief Prve najdene mrtve stavy, najviac REACHABILITY_DEADLOCKS.
+ * \return znackovania mrtvych stavov
+ */
+const QList<SimMarking> & Reachability::deadlock_markings() const {
+    return my_deadlock_markings;
+}
+
+/**
+ * \brief Spristupnenie popisu limitu, ktorym bola analyza ukoncena.
+ * \return popis limitu, prazdny ak bol preskumany cely stavovy priestor
+ */
+const QString & Reachability::limit() const {
+    return my_limit;
+}
+
+/**
+ * \brief Spristupnenie chybovej hlasky simulacie prechodu.
+ * \return chybova hlaska
+ */
+const QString & Reachability::error() const {
+    return my_error;
+}
@@ -9,12 +9,23 @@
 #include <QtGlobal>
 #include <QObject>
 #include <QTcpServer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QTimerEvent>
 #include <QtNetwork>
 
+#include <csignal>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <pthread.h>
+#endif
+
 #include <pn/server/projectdb.h>
 #include <pn/server/user.h>
 #include <pn/server/userdb.h>
 #include <pn/server/serverthread.h>
+#include <pn/server/answer.h>
 #include <pn/server/debug.h>
 
 #include <pn/server/server2012.h>
@@ -22,21 +33,76 @@
 const qint64 FILE_LINE_SIZE   = 256;
 const char * USERDB_SEPARATOR = ":";
 
+/**
+ * Predvoleny pocet spojeni cakajucich na volne vlakno.
+ */
+const unsigned SERVER_QUEUE_SIZE = 64;
+/**
+ * Cas v milisekundach na odoslanie odpovede pri odmietnuti spojenia.
+ */
+const int SERVER_REJECT_TIMEOUT = 1000;
+/**
+ * Predvoleny maximalny pocet otvorenych simulacii.
+ */
+const unsigned SERVER_SESSIONS = 64;
+/**
+ * Predvolena doba necinnosti otvorenej simulacie v sekundach.
+ */
+const unsigned SERVER_SESSION_TTL = 600;
+/**
+ * Predvolena kapacita pamate prelozenych sieti v MiB.
+ */
+const unsigned SERVER_NET_CACHE = 64;
+/**
+ * Predvoleny interval zapisu logu simulacii v ms.
+ */
+const unsigned SERVER_SIMLOG_INTERVAL = 1000;
+/**
+ * Predvolena pamat pre stavy jednej analyzy dosiahnutelnosti v MiB.
+ */
+const unsigned SERVER_REACH_MEMORY = 64;
+/**
+ * Interval v milisekundach, v ktorom hlavne vlakno overi ziadost o ukoncenie
+ * a ukonci necinne udrziavane spojenia.
+ */
+const int SERVER_STOP_POLL = 500;
+/**
+ * Cas v milisekundach, po ktorom server ukonci necinne udrziavane spojenie.
+ */
+const qint64 SERVER_IDLE_TIMEOUT = 10000;
+
+/**
+ * Ziadost o ukoncenie servru, nastavuje ju obsluha signalu.
+ */
+static volatile std::sig_atomic_t server_stopping = 0;
+
 /**
  * \brief Konstruktor servru nastavi prislusny port a zaistiti vypis informacii
  *        o spustenom servri
  * \param port Cislo portu na ktorom ma sluzba odpocuvat
  * \param userdb Nazov suboru, ktory sa ma pouzit pre uzivatelsky databazu.
  * \param projectdb Nazov adresara, ktory sa ma pouzit pre uchovavanie projekt.
+ * \param config Nastavenia servru.
  * \param parent Ukazatel na predchadzajuci objekt Qt.
  */
 Server::Server(unsigned port, const char * userdb,
-               const char * projectdb, QObject * parent)
-        : QTcpServer(parent), my_projects(projectdb),
-        my_sem_projdb(1), my_sem_userdb(1), my_sem_simlog(1) {
+               const char * projectdb, const ServerConfig & config,
+               QObject * parent)
+        : QTcpServer(parent), my_projects(projectdb, config.pack),
+        my_simlog(my_projects, config.simlog_interval),
+        my_sem_projdb(1), my_sem_userdb(1),
+        my_sessions(config.sessions, config.session_ttl),
+        my_nets(config.net_cache) {
     QString ip_addr;
 
     my_userdb = userdb;
+    my_config = config;
+    my_stopping = false;
+    my_clock.start();
+    my_timer = this->startTimer(SERVER_STOP_POLL);
+    my_accepted = 0;
+    my_rejected = 0;
+    my_queue_peak = 0;
     this->load_userdb();
 
     this->setMaxPendingConnections(20);     // Maximalny pocet pripojeni
@@ -59,8 +125,18 @@ Server::Server(unsigned port, const char * userdb,
     if (ip_addr.isEmpty())
         ip_addr = QHostAddress(QHostAddress::LocalHost).toString();
 
+    my_simlog.start();
+
+    // Spustenie vlakien, ktore vybavuju spojenia.
+    for (unsigned i = 0; i < my_config.threads; ++i) {
+        ServerThread * thread = new ServerThread(this);
+        my_workers.push_back(thread);
+        thread->start();
+    }
+
     qDebug() << "Server is running" << ip_addr
-             << "listening on port" << this->serverPort();
+             << "listening on port" << this->serverPort()
+             << "with" << my_config.threads << "threads";
     debug("Ready to serve...");
 }
 
@@ -69,19 +145,251 @@ Server::Server(unsigned port, const char * userdb,
  */
 Server::~Server() {
     debug("Shutting down the server...");
+
+    my_conn_mutex.lock();
+    my_stopping = true;
+    my_conn_cond.wakeAll();
+    my_conn_mutex.unlock();
+
+    for (int i = 0; i < my_workers.size(); ++i) {
+        my_workers[i]->wait();
+        delete my_workers[i];
+    }
+
+    // Necinne udrziavane spojenia, vlakna uz nebezia.
+    for (int i = 0; i < my_parking.size(); ++i)
+        my_parked.insert(my_parking[i].socket, my_parking[i]);
+    my_parking.clear();
+    while (! my_parked.isEmpty())
+        this->close_parked(my_parked.begin().key());
+
+    // Zaznamy, ktore este neboli zapisane.
+    my_simlog.stop();
+
+    qDebug() << "Connections accepted:" << my_accepted
+             << "rejected:" << my_rejected
+             << "queue peak:" << my_queue_peak;
 }
 
 /**
  * \brief Predefinovana metoda QTcpServer pre vybavovanie poziadavkov vo
- * vlaknach.
- * \param socket Socket pre ktory sa ma spustit nove vlakno.
+ * vlaknach. Spojenie sa zaradi do fronty, z ktorej si ho vyberie volne vlakno.
+ * Pri plnej fronte je spojenie odmietnute.
+ * \param socket Socket, ktory sa ma vybavit.
  * \retval void
  */
 void Server::incomingConnection(int socket) {
-    ServerThread * thread = new ServerThread(socket, this);
     debug("Incomming connection");
-    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-    thread->start();
+
+    my_conn_mutex.lock();
+    if (static_cast<unsigned>(my_connections.size()) >= my_config.queue) {
+        my_rejected++;
+        my_conn_mutex.unlock();
+
+        this->reject(socket);
+        return;
+    }
+
+    my_connections.enqueue(socket);
+    my_accepted++;
+    if (static_cast<unsigned>(my_connections.size()) > my_queue_peak)
+        my_queue_peak = my_connections.size();
+
+    my_conn_cond.wakeOne();
+    my_conn_mutex.unlock();
+}
+
+/**
+ * \brief Odmietnutie spojenia pri preplnenej fronte - klientovi sa zasle
+ * standardna chybova odpoved.
+ * \param socket Socket odmietaneho spojenia.
+ * \retval void
+ */
+void Server::reject(int socket) {
+    QTcpSocket conn;
+
+    if (! conn.setSocketDescriptor(socket))
+        return;
+
+    Server::busy(conn);
+    conn.disconnectFromHost();
+
+    qDebug() << "Server busy, rejected connections:" << my_rejected;
+}
+
+/**
+ * \brief Zaslanie standardnej chybovej odpovede "Server busy".
+ * \param socket Socket spojenia, na ktorom nebol vybaveny ziadny poziadavok.
+ * \retval void
+ */
+void Server::busy(QTcpSocket & socket) {
+    Answer answer(&socket);
+
+    answer.set_standard(ANSWER_BUSY);
+    answer.send();
+    socket.flush();
+    socket.waitForBytesWritten(SERVER_REJECT_TIMEOUT);
+}
+
+/**
+ * \brief Vyber spojenia z fronty, ak je fronta prazdna, vlakno caka.
+ * Udrziavane spojenia s dalsim poziadavkom maju prednost pred novymi. Pri
+ * ukonceni servru sa najprv vybavia spojenia, ktore uz su vo fronte.
+ * \param conn Vybrane spojenie.
+ * \return false pri ukonceni servru s prazdnou frontou.
+ */
+bool Server::take_connection(ServerConnection & conn) {
+    bool rv = true;
+
+    my_conn_mutex.lock();
+    while (my_connections.isEmpty() && my_resumed.isEmpty() && ! my_stopping)
+        my_conn_cond.wait(&my_conn_mutex);
+
+    if (! my_resumed.isEmpty()) {
+        conn = my_resumed.dequeue();
+    } else if (! my_connections.isEmpty()) {
+        conn = ServerConnection();
+        conn.descriptor = my_connections.dequeue();
+    } else {
+        rv = false;
+    }
+    my_conn_mutex.unlock();
+
+    return rv;
+}
+
+/**
+ * \brief Odlozenie necinneho udrziavaneho spojenia, vola ho vlakno, ktore
+ * spojenie vybavovalo. Socket prejde do hlavneho vlakna, ktore ho s dalsim
+ * poziadavkom vrati do fronty (watch()). Pri ukonceni servru sa spojenie
+ * neodklada.
+ * \param conn Spojenie so socketom a overenym uzivatelom.
+ * \return false, ak spojenie nebolo odlozene a vlakno ho musi ukoncit.
+ */
+bool Server::park(const ServerConnection & conn) {
+    Q_ASSERT(conn.socket);
+
+    my_conn_mutex.lock();
+    if (my_stopping) {
+        my_conn_mutex.unlock();
+        return false;
+    }
+
+    conn.socket->moveToThread(this->thread());
+    my_parking.push_back(conn);
+    my_conn_mutex.unlock();
+
+    QMetaObject::invokeMethod(this, "watch", Qt::QueuedConnection);
+    return true;
+}
+
+/**
+ * \brief Sledovanie odlozenych spojeni v hlavnom vlakne. Spojenie, na ktorom
+ * su data alebo ho klient ukoncil, sa vrati do fronty (resume()).
+ * \retval void
+ */
+void Server::watch() {
+    QList<ServerConnection> parking;
+
+    my_conn_mutex.lock();
+    parking = my_parking;
+    my_parking.clear();
+    my_conn_mutex.unlock();
+
+    for (int i = 0; i < parking.size(); ++i) {
+        QTcpSocket * socket = parking[i].socket;
+
+        parking[i].parked = my_clock.elapsed();
+        my_parked.insert(socket, parking[i]);
+        connect(socket, SIGNAL(readyRead()), this, SLOT(resume()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(resume()));
+
+        // Data mohli prist pred pripojenim signalov.
+        if (socket->bytesAvailable() > 0)
+            this->requeue(socket);
+    }
+}
+
+/**
+ * \brief Obsluha signalu odlozeneho socketu.
+ * \retval void
+ */
+void Server::resume() {
+    QTcpSocket * socket = qobject_cast<QTcpSocket *>(this->sender());
+
+    if (socket)
+        this->requeue(socket);
+}
+
+/**
+ * \brief Zaradenie odlozeneho spojenia do fronty. Udrziavane spojenie sa
+ * do limitu fronty nezapocitava. Socket nema vlakno, kym si ho neprevezme
+ * vlakno, ktore ho vybavi.
+ * \param socket Socket odlozeneho spojenia.
+ * \retval void
+ */
+void Server::requeue(QTcpSocket * socket) {
+    QHash<QTcpSocket *, ServerConnection>::iterator it = my_parked.find(socket);
+    ServerConnection conn;
+
+    // Spojenie uz bolo zaradene (readyRead aj disconnected).
+    if (it == my_parked.end())
+        return;
+
+    conn = it.value();
+    my_parked.erase(it);
+    socket->disconnect(this);
+    socket->moveToThread(0);
+
+    my_conn_mutex.lock();
+    my_resumed.enqueue(conn);
+    my_conn_cond.wakeOne();
+    my_conn_mutex.unlock();
+}
+
+/**
+ * \brief Ukoncenie odlozeneho spojenia.
+ * \param socket Socket odlozeneho spojenia.
+ * \retval void
+ */
+void Server::close_parked(QTcpSocket * socket) {
+    my_parked.remove(socket);
+    socket->disconnect(this);
+    socket->disconnectFromHost();
+    delete socket;
+}
+
+/**
+ * \brief Periodicke overenie ziadosti o ukoncenie (server2012_stop())
+ * a ukoncenie spojeni necinnych dlhsie ako SERVER_IDLE_TIMEOUT.
+ * \param event Udalost casovaca.
+ * \retval void
+ */
+void Server::timerEvent(QTimerEvent * event) {
+    QHash<QTcpSocket *, ServerConnection>::const_iterator it;
+    QList<QTcpSocket *> idle;
+    qint64 now;
+
+    if (event->timerId() != my_timer) {
+        QTcpServer::timerEvent(event);
+        return;
+    }
+
+    if (server_stopping) {
+        QCoreApplication::quit();
+        return;
+    }
+
+    now = my_clock.elapsed();
+    for (it = my_parked.constBegin(); it != my_parked.constEnd(); ++it) {
+        if (now - it.value().parked > SERVER_IDLE_TIMEOUT)
+            idle.push_back(it.key());
+    }
+
+    for (int i = 0; i < idle.size(); ++i) {
+        debug("Idle connection closed");
+        this->close_parked(idle[i]);
+    }
 }
 
 /**
@@ -139,15 +447,6 @@ bool Server::update_userdb(const QString & username, const QString & password) {
     return true;
 }
 
-/**
- * \brief Metoda pre cyklenie a pasivneho cakania na prichadzajuce poziadavky.
- * \return bool Informacia o dostupnosti spojenia
- * \retval bool true, ak je spojenie dostupne.
- */
-bool Server::loop() {
-    return this->waitForNewConnection(-1);
-}
-
 /**
  * \brief Zapuzdrena metoda pre zistenie existencie uzivatela.
  * \param username Meno uzivatela, ktoreho existencia sa ma zistit.
@@ -199,19 +498,51 @@ ProjectDB & Server::projects() {
     return my_projects;
 }
 
+/**
+ * Spristupnenie databazy otvorenych simulacii.
+ * \return Databaza otvorenych simulacii.
+ */
+SessionDB & Server::sessions() {
+    return my_sessions;
+}
+
+/**
+ * Spristupnenie pamate prelozenych sieti.
+ * \return Pamat prelozenych sieti.
+ */
+NetCache & Server::nets() {
+    return my_nets;
+}
+
+/**
+ * Spristupnenie limitov simulacie na serveri.
+ * \return Limity simulacie, 0 znamena bez obmedzenia.
+ */
+const SimBudget & Server::budget() const {
+    return my_config.budget;
+}
+
+/**
+ * Spristupnenie pamate pre stavy analyzy dosiahnutelnosti.
+ * \return Pamat v MiB, 0 znamena bez obmedzenia.
+ */
+unsigned Server::reach_memory() const {
+    return my_config.reach_memory;
+}
+
 /**
  * \brief Zapuzdrena metoda pre pridanie projektu.
  * \param pname Nazov pridavaneho projektu.
  * \param username Meno uzivatela, ktory projekt pridal.
  * \param desc Popis pridavanej verzie projektu.
  * \param xml XML data pridavaneho projektu.
- * \return Informacia o uspesnosti pridania projektu.
+ * \return Cislo pridanej verzie, 0 pri chybe.
  */
-bool Server::add_project(const QString & pname,
-                         const QString & username,
-                         const QString & desc,
-                         const QString & xml) {
-    bool rv;
+unsigned Server::add_project(const QString & pname,
+                             const QString & username,
+                             const QString & desc,
+                             const QByteArray & xml) {
+    unsigned rv;
 
     my_sem_projdb.acquire();
 
@@ -223,42 +554,93 @@ bool Server::add_project(const QString & pname,
 }
 
 /**
- * \brief Zapuzdrena metoda pre aktualizaciu logu projektu.
+ * \brief Zapuzdrena metoda pre aktualizaciu logu projektu. Zaznam sa len
+ * zaradi do fronty, zapise ho vlakno logu simulacii.
  * \param username Nazov uzivatela, ktory simuloval projekt.
  * \param pname Nazov projektu pre aktualizaciu.
  * \param version Verzia projektu, ktora bola simulovana
  * \return Informacia o uspesnosti aktualizacie projektu
- * \retval true v pripade uspesnej aktualizacie projektu
+ * \retval true ak projekt v danej verzii existuje
  */
 bool Server::update_simlog(const QString & username,
                  const QString & pname,
                  unsigned version) {
-    bool rv;
-
-    my_sem_simlog.acquire();
-
-    rv = my_projects.update_simlog(username, pname, version);
+    if (! my_projects.exist(pname, version))
+        return false;
 
-    my_sem_simlog.release();
+    my_simlog.append(username, pname, version);
+    return true;
+}
 
-    return rv;
+/**
+ * \brief Pockanie na zapis zaradenych zaznamov logu simulacii pred jeho
+ * citanim.
+ */
+void Server::flush_simlog() {
+    my_simlog.flush();
 }
 
 /******************************************************************************/
 
 /**
- * \brief Hlavna funkcia servru zabezbecujuca neustale vybavovanie poziadavkov.
+ * \brief Hlavna funkcia servru zabezbecujuca vybavovanie poziadavkov az do
+ * ziadosti o ukoncenie (server2012_stop()).
  * \param port Port na ktorom ma server poziadavky vybavovat.
  * \param userdb Nazov suboru, ktory sa ma pouzit pre uzivatelsky databazu.
  * \param projectdb Nazov adresara, ktory sa ma pouzit pre uchovavanie projekt.
+ * \param config Nastavenia servru.
  * \retval void
  */
-void server2012(unsigned port, const char * userdb, const char * projectdb) {
+void server2012(unsigned port, const char * userdb, const char * projectdb,
+                const ServerConfig & config) {
     Q_ASSERT(userdb);
-    Server server(port, userdb, projectdb);
 
-    forever {
-        server.loop();
-    }
+#ifdef Q_OS_UNIX
+    // Vlakna servru (aj vlakna QThreadPool, ktore vytvaraju) signaly ukoncenia
+    // neprijimaju - dorucia sa hlavnemu vlaknu a ~Server zapise log simulacii.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, 0);
+#endif
+
+    Server server(port, userdb, projectdb, config);
+
+#ifdef Q_OS_UNIX
+    pthread_sigmask(SIG_UNBLOCK, &mask, 0);
+#endif
+
+    // Prichadzajuce a necinne udrziavane spojenia sleduje hlavne vlakno.
+    QCoreApplication::exec();
 }
 
+/**
+ * \brief Ziadost o ukoncenie servru. Je mozne ju volat z obsluhy signalu,
+ * server2012() sa vrati najneskor po SERVER_STOP_POLL a server sa korektne
+ * ukonci - dovybavi spojenia a zapise zaznamy logu simulacii.
+ * \retval void
+ */
+void server2012_stop() {
+    server_stopping = 1;
+}
+
+/**
+ * \brief Predvolene nastavenia servru.
+ * \return Nastavenia servru.
+ */
+ServerConfig server_default_config() {
+    ServerConfig config;
+
+    config.budget = Simulation::default_budget();
+    config.threads = qMax(QThread::idealThreadCount(), 1);
+    config.queue = SERVER_QUEUE_SIZE;
+    config.sessions = SERVER_SESSIONS;
+    config.session_ttl = SERVER_SESSION_TTL;
+    config.net_cache = SERVER_NET_CACHE;
+    config.pack = false;
+    config.simlog_interval = SERVER_SIMLOG_INTERVAL;
+    config.reach_memory = SERVER_REACH_MEMORY;
+
+    return config;
+}
@@ -12,24 +12,21 @@ SOURCES =   main.cpp \
             server2012.cpp \
             projectdb.cpp \
             simulation.cpp \
+            reachability.cpp \
+            simnet.cpp \
+            tokenstore.cpp \
+            expr.cpp \
             userdb.cpp \
             user.cpp \
             serverthread.cpp\
+            sessiondb.cpp \
+            netcache.cpp \
+            simlogwriter.cpp \
             debug.cpp\
-            ../proto.cpp \
-            ../pnobject.cpp \
-            ../arrow.cpp \
-            ../place.cpp \
-            ../transition.cpp \
-            ../pnlist.cpp
+            ../proto.cpp
 
 
 HEADERS +=  ../include/pn/proto.h \
-            ../include/pn/pnobject.h \
-            ../include/pn/arrow.h \
-            ../include/pn/place.h \
-            ../include/pn/transition.h \
-            ../include/pn/pnlist.h \
             ../include/pn/server/user.h \
             ../include/pn/server/userdb.h \
             ../include/pn/server/projectdb.h \
@@ -37,10 +34,18 @@ HEADERS +=  ../include/pn/proto.h \
             ../include/pn/server/message.h \
             ../include/pn/server/server2012.h \
             ../include/pn/server/simulation.h \
+            ../include/pn/server/reachability.h \
+            ../include/pn/server/simnet.h \
+            ../include/pn/server/tokenstore.h \
+            ../include/pn/server/expr.h \
             ../include/pn/server/serverthread.h \
+            ../include/pn/server/sessiondb.h \
+            ../include/pn/server/netcache.h \
+            ../include/pn/server/simlogwriter.h \
             ../include/pn/server/debug.h
 
 QMAKE_CXXFLAGS += -std=c++98 -Wall -Wextra -Wswitch-enum
 
 QT += network xml script
+QT -= gui
 
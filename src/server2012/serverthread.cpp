@@ -8,73 +8,434 @@
 
 #include <QThread>
 #include <QTcpSocket>
+#include <QScriptEngine>
 
 #include <pn/server/answer.h>
 #include <pn/server/message.h>
 #include <pn/server/simulation.h>
+#include <pn/server/reachability.h>
+#include <pn/server/sessiondb.h>
+#include <pn/server/netcache.h>
 #include <pn/server/debug.h>
 
 #include <pn/server/serverthread.h>
 
 /**
- * \brief Konstruktor pre vlakno spracovavajuce poziadavok na serveri.
- * \param socket_desc Socket deskriptor pre spracovanie odpovedi
+ * Cas v milisekundach, pocas ktoreho vlakno caka na dalsi poziadavok spojenia,
+ * potom spojenie odlozi (Server::park()).
+ */
+const int SERVER_IDLE_WAIT = 50;
+/**
+ * Najvacsi pocet simulacii jedneho poziadavku BATCH.
+ */
+const int SERVER_BATCH_RUNS = 4096;
+
+const char * SERVER_ERR_MARKING = "Bad marking: ";
+
+/**
+ * \brief Konstruktor pre vlakno spracovavajuce poziadavky na serveri.
  * \param parent Ukazatel na server.
  */
-ServerThread::ServerThread(int socket_desc, QObject * parent)
+ServerThread::ServerThread(QObject * parent)
     : QThread(parent) {
-    my_socket_desc = socket_desc;
     my_server = static_cast<Server*>(parent);
+    my_engine = 0;
 }
 
 /**
  * \brief Destruktor pre vlakno spracovavajuce poziadavok na serveri.
  */
 ServerThread::~ServerThread() {
+    delete my_engine;
+}
+
+/**
+ * \brief Spristupnenie interpretu ECMAScriptu vlakna. Interpret sa vytvori pri
+ * prvom pouziti a je zdielany vsetkymi simulaciami vlakna.
+ * \return interpret vlakna
+ */
+QScriptEngine * ServerThread::engine() {
+    if (! my_engine)
+        my_engine = new QScriptEngine;
+    return my_engine;
 }
 
 /**
- * \brief Spustenie samostatneho vlakna na serveri.
+ * \brief Limity simulacie pre poziadavok - limity zadane klientom nemozu
+ * prekrocit limity serveru.
+ * \param msg Poziadavok na simulaciu.
+ * \return Limity simulacie.
+ */
+SimBudget ServerThread::budget(const Message & msg) const {
+    SimBudget request;
+
+    request.steps = msg.steps();
+    request.time = msg.timeout();
+    request.tokens = msg.tokens();
+
+    return Simulation::budget(my_server->budget(), request);
+}
+
+/**
+ * \brief Prelozena siet pre poziadavok - zo siete zaslanej v poziadavku,
+ * alebo z projektu na serveri, ak poziadavok XML neobsahuje. Siet sa hlada
+ * najprv v pamati prelozenych sieti, nova siet sa do nej ulozi.
+ * \param msg Poziadavok na simulaciu.
+ * \return Siet, prazdny ukazatel ak projekt nie je mozne nacitat alebo siet
+ * nie je korektna.
+ */
+SimNetPtr ServerThread::net(const Message & msg) {
+    NetCache & cache = my_server->nets();
+    QByteArray xml = msg.xml();
+    QString key;
+    SimNetPtr rv;
+    SimNet * net;
+
+    if (xml.isEmpty())
+        key = NetCache::project_key(msg.project(), msg.version());
+    else
+        key = NetCache::xml_key(xml);
+
+    rv = cache.find(key);
+    if (! rv.isNull()) {
+        debug("Compiled net found");
+        return rv;
+    }
+
+    if (xml.isEmpty()
+        && ! my_server->projects().xml_data(xml, msg.project(),
+                                            msg.version()))
+        return rv;
+
+    net = new SimNet;
+    if (! net->from_xml(xml)) {
+        delete net;
+        return rv;
+    }
+
+    rv = SimNetPtr(net);
+    cache.insert(key, rv, xml.size());
+    return rv;
+}
+
+/**
+ * \brief Spustenie samostatneho vlakna na serveri. Vlakno vybavuje spojenia
+ * z fronty servru, kym nie je server ukonceny.
  * \retval void
  */
 void ServerThread::run() {
-    QTcpSocket socket;
-     if (!socket.setSocketDescriptor(my_socket_desc)) {
-         return;
-     }
-
-     debug("Waiting for client to ready");
-     if (socket.waitForReadyRead()) {
-        // Vybavenie dotazovanej poziadavky
-        this->handle_request(socket);
+    ServerConnection conn;
+
+    while (my_server->take_connection(conn))
+        this->handle_connection(conn);
+
+    // Interpret patri vlaknu, musi byt odstraneny v nom.
+    delete my_engine;
+    my_engine = 0;
+}
+
+/**
+ * \brief Vybavenie spojenia. Poziadavky sa vybavuju v poradi, v akom ich
+ * klient zaslal, kym prichadzaju do SERVER_IDLE_WAIT. Necinne udrziavane
+ * spojenie vlakno neblokuje - odlozi ho (Server::park()) a s dalsim
+ * poziadavkom sa spojenie vrati do fronty servru.
+ * \param conn Nove alebo udrziavane spojenie.
+ * \retval void
+ */
+void ServerThread::handle_connection(ServerConnection & conn) {
+    QTcpSocket * socket = conn.socket;
+    bool answered = socket != 0;
+
+    if (socket) {
+        // Odlozeny socket nema vlakno, prevezme ho toto vlakno.
+        socket->moveToThread(QThread::currentThread());
     } else {
-        debug("Connection time out");
+        socket = new QTcpSocket;
+        if (! socket->setSocketDescriptor(conn.descriptor)) {
+            delete socket;
+            return;
+        }
+    }
+
+    // Overenie uzivatela plati len v ramci jedneho spojenia.
+    my_username = conn.username;
+    my_password = conn.password;
+
+    // Dalsie poziadavky mohli byt zaslane este pred prijatim odpovedi.
+    while (socket->bytesAvailable() > 0
+           || socket->waitForReadyRead(SERVER_IDLE_WAIT)) {
+        answered = true;
+        if (! this->handle_request(*socket)) {
+            debug("Request handled");
+            socket->disconnectFromHost();
+            delete socket;
+            return;
+        }
+    }
+
+    conn.socket = socket;
+    conn.username = my_username;
+    conn.password = my_password;
+    if (socket->state() == QAbstractSocket::ConnectedState
+        && my_server->park(conn)) {
+        debug("Connection parked");
+        return;
+    }
+
+    // Server sa ukoncuje, spojenie bez odpovede sa odmietne.
+    if (! answered && socket->state() == QAbstractSocket::ConnectedState)
+        Server::busy(*socket);
+
+    debug("Connection closed");
+    socket->disconnectFromHost();
+    delete socket;
+}
+
+/**
+ * \brief Overenie uzivatela poziadavku. Pri udrziavanom spojeni sa uspesne
+ * overeny uzivatel zapamata a dalsie poziadavky s rovnakymi udajmi sa uz
+ * v databaze uzivatelov neoveruju.
+ * \param msg Rozparsovany poziadavok.
+ * \return true, ak su udaje uzivatela spravne.
+ */
+bool ServerThread::authorized(const Message & msg) {
+    if (! my_username.isEmpty() && msg.username() == my_username
+        && msg.password() == my_password)
+        return true;
+
+    if (! my_server->exist_user(msg.username())
+        || ! my_server->verify_user(msg.username(), msg.password()))
+        return false;
+
+    if (msg.keep()) {
+        my_username = msg.username();
+        my_password = msg.password();
     }
 
-     debug("Request handled");
-     socket.disconnectFromHost();
-     //socket.waitForDisconnected();
+    return true;
+}
+
+/**
+ * \brief Otvorenie simulacie na serveri. Siet sa prelozi raz a dalsie
+ * poziadavky STEP, RUN a RESET s polozkou SESSION pracuju s jej znackovanim.
+ * \param msg Poziadavok OPEN so sietou v XML alebo projektom na serveri.
+ * \param answer Odpoved s identifikatorom simulacie.
+ * \retval void
+ */
+void ServerThread::open_session(const Message & msg, Answer & answer) {
+    SimNetPtr net;
+    QString id;
+    Simulation * sim;
+
+    if (msg.xml().isEmpty()
+        && ! my_server->exist_project(msg.project(), msg.version())) {
+        answer.set_standard(ANSWER_UNKNOWN);
+        debug("Bad OPEN");
+        return;
+    }
+
+    net = this->net(msg);
+    if (net.isNull()) {
+        answer.set_standard(ANSWER_BAD_XML);
+        debug("Bad XML OPEN");
+        return;
+    }
+
+    sim = new Simulation(this->engine());
+    sim->prepare(net);
+
+    id = my_server->sessions().open(msg.username(), msg.project(),
+                                    msg.version(), sim);
+    if (id.isEmpty()) {
+        delete sim;
+        answer.set_standard(ANSWER_BAD_OPEN);
+        debug("Bad OPEN, too many sessions");
+        return;
+    }
+
+    answer.set_session(id);
+    debug("OPEN");
+}
+
+/**
+ * \brief Vybavenie poziadavku na otvorenu simulaciu (STEP, RUN, RESET, CLOSE).
+ * \param msg Poziadavok s polozkou SESSION.
+ * \param answer Odpoved na poziadavok.
+ * \retval void
+ */
+void ServerThread::handle_session(const Message & msg, Answer & answer) {
+    Session * session;
+    bool rv;
+
+    session = my_server->sessions().acquire(msg.session(), msg.username());
+    if (! session) {
+        answer.set_standard(ANSWER_BAD_SESSION);
+        debug("Bad SESSION");
+        return;
+    }
+
+    if (msg.type() == REQ_CLOSE) {
+        my_server->sessions().close(session);
+        answer.set_standard(ANSWER_OK_CLOSE);
+        debug("CLOSE");
+        return;
+    }
+
+    if (msg.type() == REQ_RESET) {
+        session->sim->reset();
+        answer.set_standard(ANSWER_OK_RESET);
+        debug("RESET");
+    } else {
+        if (! session->project.isEmpty()) {
+            if (! my_server->update_simlog(msg.username(), session->project,
+                                           session->version)) {
+                debug("E: Failed to update SIMLOG");
+            }
+        }
+
+        session->sim->set_engine(this->engine());
+        session->sim->set_budget(this->budget(msg));
+
+        rv = msg.type() == REQ_RUN ? session->sim->run()
+                                   : session->sim->step();
+
+        if (rv && msg.delta()) {
+            answer.set_delta(*session->sim);
+            debug("SESSION STEP DELTA");
+        } else if (rv) {
+            answer.set_xml(*session->sim);
+            debug("SESSION STEP");
+        } else {
+            answer.set_error(session->sim->error());
+            debug("Bad SESSION STEP");
+        }
+    }
+
+    // Programy su viazane na interpret tohto vlakna.
+    session->sim->release_scripts();
+    my_server->sessions().release(session);
+}
+
+/**
+ * \brief Suborova simulacia - siet sa prelozi raz a odsimuluje z pociatocneho
+ * znackovania zmeneneho kazdou polozkou MARKING.
+ * \param msg Poziadavok BATCH so sietou v XML alebo projektom na serveri.
+ * \param answer Odpoved s vyslednymi znackovaniami.
+ * \retval void
+ */
+void ServerThread::run_batch(const Message & msg, Answer & answer) {
+    QVector<SimRun> runs;
+    SimNetPtr net;
+
+    if (msg.markings().size() > SERVER_BATCH_RUNS) {
+        answer.set_standard(ANSWER_BAD_REQ);
+        debug("Bad BATCH, too many runs");
+        return;
+    }
+
+    if (msg.xml().isEmpty()
+        && ! my_server->exist_project(msg.project(), msg.version())) {
+        answer.set_standard(ANSWER_UNKNOWN);
+        debug("Bad BATCH");
+        return;
+    }
+
+    net = this->net(msg);
+    if (net.isNull()) {
+        answer.set_standard(ANSWER_BAD_XML);
+        debug("Bad XML BATCH");
+        return;
+    }
+
+    runs.resize(msg.markings().size());
+    for (int i = 0; i < runs.size(); ++i) {
+        runs[i].marking = net->initial_marking();
+        if (! net->parse_marking(msg.markings()[i], runs[i].marking)) {
+            answer.set_error(SERVER_ERR_MARKING + msg.markings()[i]);
+            debug("Bad MARKING BATCH");
+            return;
+        }
+    }
+
+    if (! msg.project().isEmpty()) {
+        if (! my_server->update_simlog(msg.username(), msg.project(),
+                                       msg.version())) {
+            debug("E: Failed to update SIMLOG");
+        }
+    }
+
+    Simulation::batch_run(net, this->budget(msg), runs, this->engine());
+    answer.set_batch(*net, runs);
+    debug("BATCH");
+}
+
+/**
+ * \brief Analyza dosiahnutelnosti - prehladanie stavoveho priestoru siete
+ * s limitom casu a pamate z poziadavku, ktore neprekracuju limity serveru.
+ * \param msg Poziadavok REACH so sietou v XML alebo projektom na serveri.
+ * \param answer Odpoved s vysledkom analyzy.
+ * \retval void
+ */
+void ServerThread::reach(const Message & msg, Answer & answer) {
+    ReachBudget budget;
+    SimNetPtr net;
+
+    if (msg.xml().isEmpty()
+        && ! my_server->exist_project(msg.project(), msg.version())) {
+        answer.set_standard(ANSWER_UNKNOWN);
+        debug("Bad REACH");
+        return;
+    }
+
+    net = this->net(msg);
+    if (net.isNull()) {
+        answer.set_standard(ANSWER_BAD_XML);
+        debug("Bad XML REACH");
+        return;
+    }
+
+    budget.time = this->budget(msg).time;
+    budget.memory = my_server->reach_memory();
+    if (msg.memory() != 0
+        && (budget.memory == 0 || msg.memory() < budget.memory))
+        budget.memory = msg.memory();
+
+    Reachability reach(this->engine());
+    if (reach.explore(net, budget)) {
+        answer.set_reach(*net, reach);
+        debug("REACH");
+    } else {
+        answer.set_error(reach.error());
+        debug("Bad REACH");
+    }
 }
 
 /**
  * \brief Metoda pre rozparsovanie a vybavenie poziadavku od klienta.
  * \param socket Socket z ktoreho sa zadana poziadavka bude parsovat.
- * \retval void
+ * \return true, ak ma spojenie zostat otvorene pre dalsi poziadavok.
  */
-void ServerThread::handle_request(QTcpSocket & socket) {
-    QString result; // vysledok v pripade simulacie.
+bool ServerThread::handle_request(QTcpSocket & socket) {
     Simulation * sim;
+    SimNetPtr net;
+    SimlogQuery query;
     unsigned version;
+    bool keep = false;
 
     Message * msg = new Message();
-    Answer * msg_back = new Answer();
+    Answer * msg_back = new Answer(&socket);
 
     debug("Parsing request...");
     if (msg->socket(&socket)) {
         debug("Request parsed");
-        if (msg->type() != REQ_REGISTER
-            && (! my_server->exist_user(msg->username())
-                || ! my_server->verify_user(msg->username(), msg->password()))) {
+        // Po chybnom poziadavku nie je mozne spolahlivo najst zaciatok
+        // dalsieho, spojenie sa preto udrziava len po spravnom poziadavku.
+        // Polozka KEEP je na zaciatku odpovede, nastavuje sa preto vopred.
+        keep = msg->keep();
+        if (keep)
+            msg_back->set_keep();
+
+        if (msg->type() != REQ_REGISTER && ! this->authorized(*msg)) {
             msg_back->set_standard(ANSWER_BAD_AUTH);
             debug("Bad AUTH");
         } else {
@@ -85,6 +446,8 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                     break;
 
                 case REQ_LOGOUT:
+                    my_username.clear();
+                    my_password.clear();
                     msg_back->set_standard(ANSWER_OK_LOGOUT);
                     debug("LOGOUT");
                     break;
@@ -144,7 +507,21 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                     }
                     break;
 
+                case REQ_OPEN:
+                    this->open_session(*msg, *msg_back);
+                    break;
+
+                case REQ_RESET:
+                    /* WALKTHRU */
+                case REQ_CLOSE:
+                    this->handle_session(*msg, *msg_back);
+                    break;
+
                 case REQ_STEP:
+                    if (! msg->session().isEmpty()) {
+                        this->handle_session(*msg, *msg_back);
+                        break;
+                    }
                     if (! msg->project().isEmpty()) {
                         if (! my_server->update_simlog(msg->username(),
                                                        msg->project(),
@@ -152,13 +529,22 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                             debug("Failed to update SIMLOG");
                         }
                     }
-                    sim = new Simulation;
-
-                    if (! sim->prepare(msg->xml())) {
+                    net = this->net(*msg);
+                    if (net.isNull()) {
                         msg_back->set_standard(ANSWER_BAD_XML);
                         debug("Bad XML STEP");
-                    } else if (sim->step(result)) {
-                        msg_back->set_xml(result);
+                        break;
+                    }
+
+                    sim = new Simulation(this->engine());
+                    sim->set_budget(this->budget(*msg));
+                    sim->prepare(net);
+
+                    if (sim->step()) {
+                        if (msg->delta())
+                            msg_back->set_delta(*sim);
+                        else
+                            msg_back->set_xml(*sim);
                         debug("STEP");
                     } else {
                         msg_back->set_error(sim->error());
@@ -169,6 +555,10 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                     break;
 
                 case REQ_RUN:
+                    if (! msg->session().isEmpty()) {
+                        this->handle_session(*msg, *msg_back);
+                        break;
+                    }
                     if (! msg->project().isEmpty()) {
                         if (! my_server->update_simlog(msg->username(),
                                                        msg->project(),
@@ -176,13 +566,22 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                             debug("E: Failed to update SIMLOG");
                         }
                     }
-                    sim = new Simulation;
-
-                    if (! sim->prepare(msg->xml())) {
+                    net = this->net(*msg);
+                    if (net.isNull()) {
                         msg_back->set_standard(ANSWER_BAD_XML);
                         debug("Bad XML STEP");
-                    } else if (sim->run(result)) {
-                        msg_back->set_xml(result);
+                        break;
+                    }
+
+                    sim = new Simulation(this->engine());
+                    sim->set_budget(this->budget(*msg));
+                    sim->prepare(net);
+
+                    if (sim->run()) {
+                        if (msg->delta())
+                            msg_back->set_delta(*sim);
+                        else
+                            msg_back->set_xml(*sim);
                         debug("STEP");
                     } else {
                         msg_back->set_error(sim->error());
@@ -192,12 +591,26 @@ void ServerThread::handle_request(QTcpSocket & socket) {
                     delete sim;
                     break;
 
+                case REQ_BATCH:
+                    this->run_batch(*msg, *msg_back);
+                    break;
+
+                case REQ_REACH:
+                    this->reach(*msg, *msg_back);
+                    break;
+
                 case REQ_SIMLOG:
                     if (my_server->exist_project(msg->project(),
                                                  msg->version())) {
+                        my_server->flush_simlog();
+                        query.from = msg->from();
+                        query.to = msg->to();
+                        query.offset = msg->offset();
+                        query.limit = msg->limit();
                         msg_back->set_simlog(my_server->projects(),
                                              msg->project(),
-                                             msg->version());
+                                             msg->version(),
+                                             query, msg->stats());
                     } else {
                         msg_back->set_standard(ANSWER_UNKNOWN);
                         debug("Bad SIMLOG");
@@ -218,14 +631,13 @@ void ServerThread::handle_request(QTcpSocket & socket) {
     }
 
     // Zasli spravu spat uzivatelovi.
-    socket.write(msg_back->text().toAscii());
+    msg_back->send();
     socket.flush();
     socket.waitForBytesWritten();
 
-    // Odstran soket.
-    socket.deleteLater();
-
     delete msg;
     delete msg_back;
+
+    return keep;
 }
 
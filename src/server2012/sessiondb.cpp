@@ -0,0 +1,183 @@
+/**
+ * \file     sessiondb.cpp
+ * \brief    Simulacie otvorene na serveri medzi poziadavkami klienta.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 12 2012
+ */
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include <pn/server/simulation.h>
+#include <pn/server/debug.h>
+#include <pn/server/sessiondb.h>
+
+/**
+ * \brief Uvolnenie simulacie a jej zaznamu.
+ * \param session Zaznam simulacie.
+ */
+static void session_free(Session * session) {
+    delete session->sim;
+    delete session;
+}
+
+/**
+ * \brief Konstruktor databazy otvorenych simulacii.
+ * \param capacity Maximalny pocet otvorenych simulacii.
+ * \param ttl Doba necinnosti v sekundach, po ktorej je simulacia odstranena,
+ * 0 znamena bez obmedzenia.
+ */
+SessionDB::SessionDB(unsigned capacity, unsigned ttl) {
+    my_capacity = capacity;
+    my_ttl = ttl;
+    my_next_id = 0;
+    my_clock.start();
+}
+
+/**
+ * \brief Destruktor, uvolni vsetky otvorene simulacie.
+ */
+SessionDB::~SessionDB() {
+    QHash<QString, Session *>::iterator it;
+
+    for (it = my_sessions.begin(); it != my_sessions.end(); ++it)
+        session_free(it.value());
+}
+
+/**
+ * \brief Vlozenie novej simulacie do databazy.
+ * \param username Uzivatel, ktory simulaciu otvara.
+ * \param project Projekt, ktoreho simulacie sa zaznamenavaju do logu.
+ * \param version Verzia projektu.
+ * \param sim Pripravena simulacia, pri uspechu ju vlastni databaza.
+ * \return Identifikator simulacie, prazdny ak je databaza plna a ziadnu
+ * simulaciu nie je mozne odstranit.
+ */
+QString SessionDB::open(const QString & username, const QString & project,
+                        unsigned version, Simulation * sim) {
+    Session * session;
+    QString id;
+
+    my_mutex.lock();
+
+    this->expire();
+    if (static_cast<unsigned>(my_sessions.size()) >= my_capacity
+        && ! this->evict()) {
+        my_mutex.unlock();
+        return QString();
+    }
+
+    session = new Session;
+    session->id = QString::number(++my_next_id);
+    session->username = username;
+    session->project = project;
+    session->version = version;
+    session->sim = sim;
+    session->used = my_clock.elapsed();
+    session->busy = false;
+    my_sessions.insert(session->id, session);
+    id = session->id;
+
+    my_mutex.unlock();
+
+    return id;
+}
+
+/**
+ * \brief Ziskanie simulacie pre vybavenie poziadavku. Simulacia musi byt po
+ * vybaveni vratena pomocou release() alebo zatvorena pomocou close().
+ * \param id Identifikator simulacie.
+ * \param username Uzivatel poziadavku, musi byt ten, ktory simulaciu otvoril.
+ * \return Simulacia, 0 ak neexistuje alebo ju prave vybavuje ine vlakno.
+ */
+Session * SessionDB::acquire(const QString & id, const QString & username) {
+    Session * session;
+
+    my_mutex.lock();
+
+    this->expire();
+    session = my_sessions.value(id, 0);
+    if (session && (session->busy || session->username != username))
+        session = 0;
+    if (session)
+        session->busy = true;
+
+    my_mutex.unlock();
+
+    return session;
+}
+
+/**
+ * \brief Vratenie simulacie ziskanej pomocou acquire().
+ * \param session Simulacia.
+ */
+void SessionDB::release(Session * session) {
+    my_mutex.lock();
+
+    session->busy = false;
+    session->used = my_clock.elapsed();
+
+    my_mutex.unlock();
+}
+
+/**
+ * \brief Zatvorenie a uvolnenie simulacie ziskanej pomocou acquire().
+ * \param session Simulacia.
+ */
+void SessionDB::close(Session * session) {
+    my_mutex.lock();
+
+    my_sessions.remove(session->id);
+    session_free(session);
+
+    my_mutex.unlock();
+}
+
+/**
+ * \brief Odstranenie simulacii necinnych dlhsie ako ttl. Volat so zamknutym
+ * my_mutex.
+ */
+void SessionDB::expire() {
+    qint64 now = my_clock.elapsed();
+
+    if (my_ttl == 0)
+        return;
+
+    QMutableHashIterator<QString, Session *> it(my_sessions);
+    while (it.hasNext()) {
+        Session * session = it.next().value();
+        if (! session->busy && now - session->used > my_ttl * qint64(1000)) {
+            debug("Session expired");
+            it.remove();
+            session_free(session);
+        }
+    }
+}
+
+/**
+ * \brief Odstranenie najdlhsie nepouzitej simulacie, ktoru prave nevybavuje
+ * ziadne vlakno. Volat so zamknutym my_mutex.
+ * \return false ak nebolo mozne ziadnu simulaciu odstranit
+ */
+bool SessionDB::evict() {
+    QHash<QString, Session *>::iterator it, oldest = my_sessions.end();
+
+    for (it = my_sessions.begin(); it != my_sessions.end(); ++it) {
+        if (it.value()->busy)
+            continue;
+        if (oldest == my_sessions.end()
+            || it.value()->used < oldest.value()->used)
+            oldest = it;
+    }
+
+    if (oldest == my_sessions.end())
+        return false;
+
+    debug("Session evicted");
+    session_free(oldest.value());
+    my_sessions.erase(oldest);
+    return true;
+}
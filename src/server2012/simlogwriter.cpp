@@ -0,0 +1,141 @@
+/**
+ * \file     simlogwriter.cpp
+ * \brief    Zapis logu simulacii vo vlakne na pozadi.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 16 2012
+ */
+
+#include <climits>
+
+#include <QThread>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDateTime>
+
+#include <pn/server/projectdb.h>
+#include <pn/server/debug.h>
+#include <pn/server/simlogwriter.h>
+
+/**
+ * \brief Pocet zaznamov vo fronte, pri ktorom sa zapisuje bez cakania na
+ * uplynutie intervalu.
+ */
+const int SIMLOG_BATCH = 1024;
+
+/**
+ * \brief Konstruktor. Vlakno je nutne spustit pomocou start().
+ * \param projects Databaza projektov, do ktorej sa log zapisuje.
+ * \param interval Interval zapisu v ms, 0 zapisuje kazdy zaznam hned.
+ */
+SimlogWriter::SimlogWriter(ProjectDB & projects, unsigned interval)
+        : my_projects(projects) {
+    my_interval = interval;
+    my_queued = 0;
+    my_written = 0;
+    my_flush = false;
+    my_stopping = false;
+}
+
+/**
+ * \brief Destruktor, zapise zvysne zaznamy.
+ */
+SimlogWriter::~SimlogWriter() {
+    this->stop();
+}
+
+/**
+ * \brief Zaradenie simulacie do logu. Cas simulacie je cas zaradenia.
+ * \param username Uzivatel, ktory simuloval.
+ * \param project Nazov projektu.
+ * \param version Verzia projektu.
+ */
+void SimlogWriter::append(const QString & username, const QString & project,
+                          unsigned version) {
+    SimlogRecord rec;
+
+    rec.time = QDateTime::currentDateTime().toTime_t();
+    rec.username = username;
+    rec.project = project;
+    rec.version = version;
+
+    my_mutex.lock();
+
+    my_queue.push_back(rec);
+    my_queued++;
+    if (my_interval == 0 || my_queue.size() >= SIMLOG_BATCH)
+        my_cond.wakeOne();
+
+    my_mutex.unlock();
+}
+
+/**
+ * \brief Pockanie na zapis vsetkych doteraz zaradenych zaznamov, aby ich
+ * citanie logu uz videlo.
+ */
+void SimlogWriter::flush() {
+    my_mutex.lock();
+
+    quint64 target = my_queued;
+    if (my_written < target) {
+        my_flush = true;
+        my_cond.wakeOne();
+        while (my_written < target)
+            my_done.wait(&my_mutex);
+    }
+
+    my_mutex.unlock();
+}
+
+/**
+ * \brief Ukoncenie vlakna po zapise zvysnych zaznamov.
+ */
+void SimlogWriter::stop() {
+    my_mutex.lock();
+    my_stopping = true;
+    my_cond.wakeOne();
+    my_mutex.unlock();
+
+    this->wait();
+}
+
+/**
+ * \brief Hlavna slucka vlakna. Zaznamy sa z fronty vyberu naraz a zapisu
+ * mimo zamku, vlakna vybavujuce poziadavky tak na zapis necakaju.
+ */
+void SimlogWriter::run() {
+    QList<SimlogRecord> batch;
+    quint64 taken;
+    bool stopping;
+
+    my_mutex.lock();
+
+    for (;;) {
+        if (! my_stopping && ! my_flush && my_queue.size() < SIMLOG_BATCH)
+            my_cond.wait(&my_mutex, my_interval ? my_interval : ULONG_MAX);
+
+        batch = my_queue;
+        my_queue.clear();
+        taken = my_queued;
+        stopping = my_stopping;
+        my_flush = false;
+
+        my_mutex.unlock();
+
+        if (! batch.isEmpty() && ! my_projects.update_simlog(batch))
+            debug("E: Failed to update SIMLOG");
+        batch.clear();
+
+        my_mutex.lock();
+
+        my_written = taken;
+        my_done.wakeAll();
+
+        if (stopping && my_queue.isEmpty())
+            break;
+    }
+
+    my_mutex.unlock();
+}
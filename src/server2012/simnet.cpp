@@ -0,0 +1,667 @@
+/**
+ * \file     simnet.cpp
+ * \brief    Skompilovana reprezentacia petriho siete pre simulaciu na serveri.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 02 2012
+ */
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QtAlgorithms>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QIODevice>
+
+#include <pn/server/debug.h>
+#include <pn/server/simnet.h>
+
+const char * SIMNET_XML_START   = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<pn>\n";
+const char * SIMNET_XML_END     = "</pn>\n";
+
+/**
+ * \brief Pri zapise XML sa caka na odoslanie dat, ak ich v zariadeni caka viac
+ * ako SIMNET_XML_CHUNK bajtov.
+ */
+const qint64 SIMNET_XML_CHUNK   = 64 * 1024;
+const int SIMNET_XML_WAIT       = 30000;    //!< Najdlhsie cakanie (ms).
+
+/**
+ * \brief Atributy a nazvy tagov v XML.
+ */
+const char * SIMNET_XML_PN          = "pn";
+const char * SIMNET_XML_ARROW       = "arrow";
+const char * SIMNET_XML_PLACE       = "place";
+const char * SIMNET_XML_TRANSITION  = "transition";
+
+const char * SIMNET_XML_X           = "point_x";
+const char * SIMNET_XML_Y           = "point_y";
+const char * SIMNET_XML_NAME        = "name";
+const char * SIMNET_XML_FROM        = "from";
+const char * SIMNET_XML_TO          = "to";
+const char * SIMNET_XML_MODE        = "mode";
+const char * SIMNET_XML_COND        = "condition";
+const char * SIMNET_XML_PRIOR       = "priority";
+const char * SIMNET_XML_VALUE       = "value";
+
+const char * SIMNET_ERR_ARROW       = "Parsing arrow failed.";
+const char * SIMNET_ERR_PLACE       = "Parsing place failed.";
+const char * SIMNET_ERR_TRANSITION  = "Parsing transition failed.";
+const char * SIMNET_ERR_ELEMENT     = "Unknown xml element type.";
+const char * SIMNET_ERR_DUPLICIT    = "Duplicit object name.";
+const char * SIMNET_ERR_NAME        = "Name error in objects - arrow name!";
+
+/**
+ * \brief Konstruktor.
+ */
+SimNet::SimNet() {
+}
+
+/**
+ * \brief Destruktor.
+ */
+SimNet::~SimNet() {
+}
+
+/**
+ * \brief Odstranenie vsetkych objektov siete.
+ */
+void SimNet::clear() {
+    my_places.clear();
+    my_transitions.clear();
+    my_arrows.clear();
+    my_order.clear();
+    my_in_offset.clear();
+    my_in_arcs.clear();
+    my_out_offset.clear();
+    my_out_arcs.clear();
+    my_ranked.clear();
+    my_rank.clear();
+    my_cons_offset.clear();
+    my_consumers.clear();
+    my_place_index.clear();
+    my_marking.clear();
+}
+
+/**
+ * \brief Metoda pre spristupnenie chybovej hlasky.
+ * \return spristupnena chybova hlaska
+ */
+const QString & SimNet::error() const {
+    return my_error;
+}
+
+/**
+ * \brief Spracovanie atributov miesta vratane jeho tokenov.
+ * \param attributes atributy miesta
+ * \return false v pripade chybnych atributov
+ */
+bool SimNet::parse_place(const QXmlStreamAttributes & attributes) {
+    bool ok;
+    SimPlace place;
+    SimTokens tokens;
+    SimElement elem;
+
+    place.x = attributes.value(SIMNET_XML_X).toString().toInt(&ok);
+    if (! ok)
+        return false;
+    place.y = attributes.value(SIMNET_XML_Y).toString().toInt(&ok);
+    if (! ok)
+        return false;
+
+    place.name = attributes.value(SIMNET_XML_NAME).toString();
+    if (place.name.isEmpty())
+        return false;
+
+    if (! SimNet::parse_value(attributes.value(SIMNET_XML_VALUE).toString(),
+                              tokens))
+        return false;
+
+    elem.kind = SimElement::PLACE;
+    elem.index = my_places.size();
+
+    my_places.push_back(place);
+    my_marking.push_back(tokens);
+    my_order.push_back(elem);
+    return true;
+}
+
+/**
+ * \brief Spracovanie atributov prechodu.
+ * \param attributes atributy prechodu
+ * \return false v pripade chybnych atributov
+ */
+bool SimNet::parse_transition(const QXmlStreamAttributes & attributes) {
+    bool ok;
+    SimTransition trans;
+    SimElement elem;
+
+    trans.x = attributes.value(SIMNET_XML_X).toString().toInt(&ok);
+    if (! ok)
+        return false;
+    trans.y = attributes.value(SIMNET_XML_Y).toString().toInt(&ok);
+    if (! ok)
+        return false;
+
+    trans.priority = attributes.value(SIMNET_XML_PRIOR).toString().toInt(&ok);
+    if (! ok)
+        return false;
+
+    trans.name = attributes.value(SIMNET_XML_NAME).toString();
+    if (trans.name.isEmpty())
+        return false;
+
+    trans.condition = attributes.value(SIMNET_XML_COND).toString();
+    trans.mode = attributes.value(SIMNET_XML_MODE).toString();
+    trans.compiled = false;
+
+    elem.kind = SimElement::TRANSITION;
+    elem.index = my_transitions.size();
+
+    my_transitions.push_back(trans);
+    my_order.push_back(elem);
+    return true;
+}
+
+/**
+ * \brief Spracovanie atributov sipky. Zavislosti sipky sa riesia az po
+ * nacitani celeho dokumentu v SimNet::compose().
+ * \param attributes atributy sipky
+ * \return false v pripade chybnych atributov
+ */
+bool SimNet::parse_arrow(const QXmlStreamAttributes & attributes) {
+    SimArrow arrow;
+    SimElement elem;
+
+    arrow.name = attributes.value(SIMNET_XML_NAME).toString();
+    arrow.from = attributes.value(SIMNET_XML_FROM).toString();
+    arrow.to = attributes.value(SIMNET_XML_TO).toString();
+
+    if (arrow.name.isEmpty() || arrow.from.isEmpty() || arrow.to.isEmpty())
+        return false;
+
+    elem.kind = SimElement::ARROW;
+    elem.index = my_arrows.size();
+
+    my_arrows.push_back(arrow);
+    my_order.push_back(elem);
+    return true;
+}
+
+/**
+ * \brief Rozparsovanie XML reprezentacie petriho siete bez vytvarania
+ * grafickych objektov.
+ * \param data XML reprezentacia petriho siete, kodovanie urci QXmlStreamReader
+ * \return v pripade chybnej petriho siete false
+ */
+bool SimNet::from_xml(const QByteArray & data) {
+    QXmlStreamReader xml(data);
+    const char * err = 0;
+
+    this->clear();
+    my_error.clear();
+
+    while (! xml.atEnd() && ! xml.hasError() && ! err) {
+        QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::StartDocument)
+            continue;
+
+        if (xml.name() == SIMNET_XML_PN)
+            continue;
+
+        if (xml.isStartElement()) {
+            if (xml.name() == SIMNET_XML_ARROW) {
+                if (! parse_arrow(xml.attributes()))
+                    err = SIMNET_ERR_ARROW;
+            } else if (xml.name() == SIMNET_XML_PLACE) {
+                if (! parse_place(xml.attributes()))
+                    err = SIMNET_ERR_PLACE;
+            } else if (xml.name() == SIMNET_XML_TRANSITION) {
+                if (! parse_transition(xml.attributes()))
+                    err = SIMNET_ERR_TRANSITION;
+            } else {
+                err = SIMNET_ERR_ELEMENT;
+            }
+        }
+    }
+
+    if (err) {
+        my_error = err;
+    } else if (xml.hasError()) {
+        my_error = xml.errorString();
+    } else if (! this->compose()) {
+        return false;
+    } else {
+        return true;
+    }
+
+    debug(my_error.toAscii().data());
+    this->clear();
+    return false;
+}
+
+/**
+ * \brief Priradenie sipok k prechodom a miestam pomocou tabulky mien a
+ * vytvorenie CSR poli vstupnych a vystupnych sipok prechodov.
+ * \return false v pripade, ze XML ma nekonzistentne zavislosti
+ */
+bool SimNet::compose() {
+    QHash<QString, int> places;
+    QHash<QString, int> transitions;
+    QVector<int> arc_trans(my_arrows.size());
+    QVector<int> arc_place(my_arrows.size());
+    QVector<bool> arc_in(my_arrows.size());
+    int tcount = my_transitions.size();
+
+    for (int i = 0; i < my_places.size(); ++i) {
+        if (places.contains(my_places[i].name)) {
+            my_error = SIMNET_ERR_DUPLICIT;
+            return false;
+        }
+        places.insert(my_places[i].name, i);
+    }
+
+    for (int i = 0; i < tcount; ++i) {
+        if (transitions.contains(my_transitions[i].name)
+                || places.contains(my_transitions[i].name)) {
+            my_error = SIMNET_ERR_DUPLICIT;
+            return false;
+        }
+        transitions.insert(my_transitions[i].name, i);
+    }
+
+    my_in_offset.fill(0, tcount + 1);
+    my_out_offset.fill(0, tcount + 1);
+
+    // Urcenie smeru sipok a pocet sipok pre kazdy prechod.
+    for (int i = 0; i < my_arrows.size(); ++i) {
+        const SimArrow & arrow = my_arrows[i];
+
+        if (places.contains(arrow.from) && transitions.contains(arrow.to)) {
+            arc_place[i] = places.value(arrow.from);
+            arc_trans[i] = transitions.value(arrow.to);
+            arc_in[i] = true;
+            my_in_offset[arc_trans[i] + 1]++;
+        } else if (transitions.contains(arrow.from)
+                && places.contains(arrow.to)) {
+            arc_trans[i] = transitions.value(arrow.from);
+            arc_place[i] = places.value(arrow.to);
+            arc_in[i] = false;
+            my_out_offset[arc_trans[i] + 1]++;
+        } else if (places.contains(arrow.from) && places.contains(arrow.to)) {
+            // Sipka medzi miestami sa simulacie nezucastnuje.
+            arc_trans[i] = -1;
+        } else {
+            my_error = SIMNET_ERR_NAME;
+            return false;
+        }
+    }
+
+    for (int t = 0; t < tcount; ++t) {
+        my_in_offset[t + 1] += my_in_offset[t];
+        my_out_offset[t + 1] += my_out_offset[t];
+    }
+
+    my_in_arcs.resize(my_in_offset[tcount]);
+    my_out_arcs.resize(my_out_offset[tcount]);
+
+    // Naplnenie CSR poli, poradie sipok prechodu zodpoveda poradiu v XML.
+    QVector<int> in_pos = my_in_offset;
+    QVector<int> out_pos = my_out_offset;
+    for (int i = 0; i < my_arrows.size(); ++i) {
+        if (arc_trans[i] < 0)
+            continue;
+
+        SimArc & arc = arc_in[i] ? my_in_arcs[in_pos[arc_trans[i]]++]
+                                 : my_out_arcs[out_pos[arc_trans[i]]++];
+        arc.name = my_arrows[i].name;
+        arc.place = arc_place[i];
+    }
+
+    // Prechody pre ktore je miesto vstupom.
+    my_cons_offset.fill(0, my_places.size() + 1);
+    for (int i = 0; i < my_in_arcs.size(); ++i)
+        my_cons_offset[my_in_arcs[i].place + 1]++;
+    for (int p = 0; p < my_places.size(); ++p)
+        my_cons_offset[p + 1] += my_cons_offset[p];
+
+    my_consumers.resize(my_in_arcs.size());
+    QVector<int> cons_pos = my_cons_offset;
+    for (int t = 0; t < tcount; ++t) {
+        for (int i = my_in_offset[t]; i < my_in_offset[t + 1]; ++i)
+            my_consumers[cons_pos[my_in_arcs[i].place]++] = t;
+    }
+
+    // Poradie simulacie - podla priority zostupne, pri rovnakej priorite podla
+    // poradia v XML.
+    QVector<QPair<int, int> > order(tcount);
+    for (int t = 0; t < tcount; ++t)
+        order[t] = qMakePair(- my_transitions[t].priority, t);
+    qSort(order);
+
+    my_ranked.resize(tcount);
+    my_rank.resize(tcount);
+    for (int r = 0; r < tcount; ++r) {
+        my_ranked[r] = order[r].second;
+        my_rank[order[r].second] = r;
+    }
+
+    for (int t = 0; t < tcount; ++t)
+        this->compile(t);
+
+    my_place_index = places;
+
+    return true;
+}
+
+/**
+ * \brief Preklad podmienky a modu prechodu. Ak sa niektory z vyrazov nepodari
+ * prelozit, prechod sa simuluje pomocou QScriptEngine. QScriptProgram si
+ * pripravuje kazda simulacia sama, siet moze byt zdielana viacerymi vlaknami.
+ * \param trans index prechodu
+ */
+void SimNet::compile(int trans) {
+    SimTransition & t = my_transitions[trans];
+    QStringList inputs;
+    QStringList outputs;
+
+    for (int i = my_in_offset[trans]; i < my_in_offset[trans + 1]; ++i)
+        inputs.append(my_in_arcs[i].name);
+    for (int i = my_out_offset[trans]; i < my_out_offset[trans + 1]; ++i)
+        outputs.append(my_out_arcs[i].name);
+
+    t.compiled = t.condition_expr.compile_condition(t.condition, inputs)
+                 && t.mode_expr.compile_mode(t.mode, inputs, outputs);
+}
+
+/**
+ * \brief Zapis XML reprezentacie siete so zadanym znackovanim. XML sa zapisuje
+ * po prvkoch priamo do zariadenia, pri sockete sa data priebezne odosielaju.
+ * \param out Zariadenie, do ktoreho sa XML zapise (UTF-8).
+ * \param marking znackovanie siete, ktore sa ma zapisat
+ */
+void SimNet::xml(QIODevice * out, const SimMarking & marking) const {
+    QXmlStreamWriter writer(out);
+    QString val;
+
+    out->write(SIMNET_XML_START);
+
+    for (int i = 0; i < my_order.size(); ++i) {
+        int idx = my_order[i].index;
+
+        if (out->bytesToWrite() > SIMNET_XML_CHUNK)
+            out->waitForBytesWritten(SIMNET_XML_WAIT);
+
+        out->write("  ");
+        switch (my_order[i].kind) {
+            case SimElement::PLACE:
+                val = SimNet::value(marking[idx]);
+
+                writer.writeStartElement(SIMNET_XML_PLACE);
+                writer.writeAttribute(SIMNET_XML_X,
+                                      QString::number(my_places[idx].x));
+                writer.writeAttribute(SIMNET_XML_Y,
+                                      QString::number(my_places[idx].y));
+                writer.writeAttribute(SIMNET_XML_NAME, my_places[idx].name);
+                writer.writeAttribute(SIMNET_XML_VALUE, val);
+                writer.writeEndElement();  // place
+                break;
+
+            case SimElement::TRANSITION:
+                writer.writeStartElement(SIMNET_XML_TRANSITION);
+                writer.writeAttribute(SIMNET_XML_X,
+                                      QString::number(my_transitions[idx].x));
+                writer.writeAttribute(SIMNET_XML_Y,
+                                      QString::number(my_transitions[idx].y));
+                writer.writeAttribute(SIMNET_XML_NAME,
+                                      my_transitions[idx].name);
+                writer.writeAttribute(SIMNET_XML_COND,
+                                      my_transitions[idx].condition);
+                writer.writeAttribute(SIMNET_XML_MODE,
+                                      my_transitions[idx].mode);
+                writer.writeAttribute(SIMNET_XML_PRIOR,
+                        QString::number(my_transitions[idx].priority));
+                writer.writeEndElement();  // transition
+                break;
+
+            case SimElement::ARROW:
+                writer.writeStartElement(SIMNET_XML_ARROW);
+                writer.writeAttribute(SIMNET_XML_FROM, my_arrows[idx].from);
+                writer.writeAttribute(SIMNET_XML_TO, my_arrows[idx].to);
+                writer.writeAttribute(SIMNET_XML_NAME, my_arrows[idx].name);
+                writer.writeEndElement();  // arrow
+                break;
+        }
+        out->write("\n");
+    }
+
+    out->write(SIMNET_XML_END);
+}
+
+/**
+ * \brief Prevod hodnoty miesta (tokeny oddelene ciarkou) na aktivne tokeny.
+ * \param value hodnota miesta tak, ako sa zapisuje do XML
+ * \param tokens tokeny miesta, pridaju sa k existujucim
+ * \return false ak niektory token nie je cislo
+ */
+bool SimNet::parse_value(const QString & value, SimTokens & tokens) {
+    bool ok;
+
+    foreach (const QString & str, value.split(",")) {
+        if (str.isEmpty())
+            continue;
+
+        tokens.active.add(str.simplified().toInt(&ok));
+        if (! ok) // Zly token - nie je cislo.
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Zmena tokenov miest znackovania. Zmeny su oddelene bodkociarkou,
+ * kazda ma tvar nazov=hodnota (napr. "p1=1,2;p2="), zmenene miesto ma len
+ * zadane tokeny.
+ * \param changes zmeny znackovania, prazdny retazec znackovanie nemeni
+ * \param marking znackovanie siete, ktore sa zmeni
+ * \return false ak zmena nema spravny tvar alebo siet nema dane miesto
+ */
+bool SimNet::parse_marking(const QString & changes,
+                           SimMarking & marking) const {
+    foreach (const QString & change, changes.split(";")) {
+        if (change.trimmed().isEmpty())
+            continue;
+
+        int pos = change.indexOf('=');
+        if (pos < 0)
+            return false;
+
+        int place = this->find_place(change.left(pos).trimmed());
+        if (place < 0)
+            return false;
+
+        SimTokens tokens;
+        if (! SimNet::parse_value(change.mid(pos + 1), tokens))
+            return false;
+        marking[place] = tokens;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Textova podoba tokenov miesta - hodnoty oddelene ciarkou, najprv
+ * aktivne a potom pasivne tokeny.
+ * \param tokens tokeny miesta
+ * \return hodnota miesta tak, ako sa zapisuje do XML
+ */
+QString SimNet::value(const SimTokens & tokens) {
+    QString val;
+
+    foreach (int token, tokens.active.values())
+        val.append(QString::number(token)).append(',');
+    foreach (int token, tokens.passive)
+        val.append(QString::number(token)).append(',');
+    val.chop(1);
+
+    return val;
+}
+
+/**
+ * \brief Pocet miest v sieti.
+ * \return pocet miest
+ */
+int SimNet::place_count() const {
+    return my_places.size();
+}
+
+/**
+ * \brief Pocet prechodov v sieti.
+ * \return pocet prechodov
+ */
+int SimNet::transition_count() const {
+    return my_transitions.size();
+}
+
+/**
+ * \brief Spristupnenie miesta.
+ * \param idx index miesta
+ * \return miesto
+ */
+const SimNet::SimPlace & SimNet::place(int idx) const {
+    return my_places[idx];
+}
+
+/**
+ * \brief Spristupnenie prechodu.
+ * \param idx index prechodu
+ * \return prechod
+ */
+const SimNet::SimTransition & SimNet::transition(int idx) const {
+    return my_transitions[idx];
+}
+
+/**
+ * \brief Index prvej vstupnej sipky prechodu.
+ * \param trans index prechodu
+ */
+int SimNet::in_begin(int trans) const {
+    return my_in_offset[trans];
+}
+
+/**
+ * \brief Index za poslednou vstupnou sipkou prechodu.
+ * \param trans index prechodu
+ */
+int SimNet::in_end(int trans) const {
+    return my_in_offset[trans + 1];
+}
+
+/**
+ * \brief Spristupnenie vstupnej sipky.
+ * \param idx index sipky v rozsahu in_begin() az in_end()
+ */
+const SimNet::SimArc & SimNet::in_arc(int idx) const {
+    return my_in_arcs[idx];
+}
+
+/**
+ * \brief Index prvej vystupnej sipky prechodu.
+ * \param trans index prechodu
+ */
+int SimNet::out_begin(int trans) const {
+    return my_out_offset[trans];
+}
+
+/**
+ * \brief Index za poslednou vystupnou sipkou prechodu.
+ * \param trans index prechodu
+ */
+int SimNet::out_end(int trans) const {
+    return my_out_offset[trans + 1];
+}
+
+/**
+ * \brief Spristupnenie vystupnej sipky.
+ * \param idx index sipky v rozsahu out_begin() az out_end()
+ */
+const SimNet::SimArc & SimNet::out_arc(int idx) const {
+    return my_out_arcs[idx];
+}
+
+/**
+ * \brief Prechod s danym poradim simulacie.
+ * \param rank poradie, 0 je prechod simulovany ako prvy
+ * \return index prechodu
+ */
+int SimNet::ranked(int rank) const {
+    return my_ranked[rank];
+}
+
+/**
+ * \brief Poradie simulacie prechodu.
+ * \param trans index prechodu
+ * \return poradie, v ktorom sa prechod simuluje v kroku simulacie
+ */
+int SimNet::rank(int trans) const {
+    return my_rank[trans];
+}
+
+/**
+ * \brief Index prveho prechodu, pre ktory je miesto vstupom.
+ * \param place index miesta
+ */
+int SimNet::consumer_begin(int place) const {
+    return my_cons_offset[place];
+}
+
+/**
+ * \brief Index za poslednym prechodom, pre ktory je miesto vstupom.
+ * \param place index miesta
+ */
+int SimNet::consumer_end(int place) const {
+    return my_cons_offset[place + 1];
+}
+
+/**
+ * \brief Spristupnenie prechodu, pre ktory je miesto vstupom.
+ * \param idx index v rozsahu consumer_begin() az consumer_end()
+ * \return index prechodu
+ */
+int SimNet::consumer(int idx) const {
+    return my_consumers[idx];
+}
+
+/**
+ * \brief Vyhladanie miesta podla nazvu.
+ * \param name nazov miesta
+ * \return index miesta, -1 ak siet miesto s danym nazvom nema
+ */
+int SimNet::find_place(const QString & name) const {
+    return my_place_index.value(name, -1);
+}
+
+/**
+ * \brief Predikat pre siet, ktorej vsetky prechody su prelozene. Takuto siet je
+ * mozne simulovat bez interpretu ECMAScriptu, aj mimo vlakna poziadavku.
+ * \return true ak su prelozene podmienky aj mody vsetkych prechodov
+ */
+bool SimNet::compiled() const {
+    foreach (const SimTransition & t, my_transitions) {
+        if (! t.compiled)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * \brief Spristupnenie znackovania siete tak, ako bolo zadane v XML.
+ * \return pociatocne znackovanie
+ */
+const SimMarking & SimNet::initial_marking() const {
+    return my_marking;
+}
@@ -8,56 +8,211 @@
 
 #include <QString>
 #include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+#include <QtAlgorithms>
 #include <QThread>
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
 #include <QDebug>
 #include <QScriptEngine>
 #include <QScriptValue>
 
-#include <pn/pnlist.h>
-#include <pn/place.h>
-#include <pn/arrow.h>
-#include <pn/transition.h>
+#include <algorithm>
+#include <functional>
+#include <climits>
+#include <cmath>
+
 #include <pn/server/debug.h>
+#include <pn/server/expr.h>
+#include <pn/server/simnet.h>
 #include <pn/server/simulation.h>
 
-const char * SIM_TIME_CYCLE = "Simulation time exceeded!";
-const char * SIM_SYN_ERROR  = "Error in expression: ";
+const char * SIM_SYN_ERROR      = "Error in expression: ";
+const char * SIM_LIMIT_STEPS    = "Step limit reached, simulation is not finished";
+const char * SIM_LIMIT_TIME     = "Time limit reached, simulation is not finished";
+const char * SIM_LIMIT_TOKENS   = "Token limit reached, simulation is not finished";
 
 /**
- * Maximalny pocet krokov simulacie kvoli zabraneniu zacykleniu.
+ * Predvoleny maximalny pocet krokov simulacie kvoli zabraneniu zacykleniu.
  */
 const unsigned SIMULATION_LOOP_COUNT = 250;
+/**
+ * Predvoleny maximalny cas simulacie v milisekundach.
+ */
+const unsigned SIMULATION_TIME = 10000;
+/**
+ * Predvoleny maximalny pocet tokenov v sieti.
+ */
+const unsigned SIMULATION_TOKENS = 1000000;
+/**
+ * Pocet skusanych tokenov pri viazani, po ktorych sa overi cas simulacie.
+ */
+const unsigned SIMULATION_PROBE_MASK = 0xff;
+/**
+ * Najmensi pocet nezavislych prechodov, ktore sa simuluju vo vlaknach naraz.
+ */
+const int SIMULATION_BATCH_MIN = 4;
+/**
+ * Najvacsi pocet prechodov jednej davky simulovanej vo vlaknach.
+ */
+const int SIMULATION_BATCH_MAX = 256;
 
 /**
  * \brief Konstruktor.
+ * \param engine interpret vlakna pre vyrazy, ktore sa nepodarilo prelozit
  */
-Simulation::Simulation() {
+Simulation::Simulation(QScriptEngine * engine) {
+    my_engine = engine;
+    my_token_count = 0;
+    my_firing.sim = this;
+    my_firing.trans = -1;
+    my_firing.probes = 0;
+    my_firing.produced = 0;
+    my_firing.parallel = false;
+    my_firing.timeout = false;
+    my_firing.fired = false;
+    my_firing.successors = 0;
+    my_batch_id = 0;
+    my_batch_max = QThread::idealThreadCount() > 1 ? SIMULATION_BATCH_MAX : 0;
+    my_epoch = 0;
+    my_generation = 0;
+    my_budget = Simulation::default_budget();
 }
 
 /**
  * \brief Destruktor.
  */
 Simulation::~Simulation() {
-    my_list.clear();
 }
 
 /**
- * \brief Priprava na simulaciu, prevod XML suboru na vnutornu reprezentaciu.
- * \param xml XML reprezentacia petriho siete
- * \return true v pripade, ze petriho siet je korektna
+ * \brief Priprava na simulaciu prelozenej siete (SimNet::from_xml(), NetCache).
+ * Siet sa nemeni, simulacia pracuje s vlastnou kopiou znackovania.
+ * \param net prelozena siet
+ */
+void Simulation::prepare(const SimNetPtr & net) {
+    my_net = net;
+
+    // QScriptProgram sa pripravuje az pri prvom pouziti prechodu.
+    my_conditions.clear();
+    my_conditions.resize(my_net->transition_count());
+    my_modes.clear();
+    my_modes.resize(my_net->transition_count());
+
+    // Konfliktne mnoziny - prechody, ktore maju spolocne vstupne alebo vystupne
+    // miesto, nie je mozne simulovat naraz. Pre kazdy prechod sa uchova
+    // zoznam jeho miest bez opakovania.
+    my_conflict_begin.clear();
+    my_conflicts.clear();
+    if (my_batch_max == 0) {
+        this->reset();
+        return;
+    }
+
+    my_conflict_begin.resize(my_net->transition_count() + 1);
+    my_batch_place.fill(0, my_net->place_count());
+    my_batch_id = 0;
+    for (int t = 0; t < my_net->transition_count(); ++t) {
+        my_conflict_begin[t] = my_conflicts.size();
+        ++my_batch_id;
+        for (int i = my_net->in_begin(t); i < my_net->in_end(t); ++i) {
+            int place = my_net->in_arc(i).place;
+            if (my_batch_place[place] != my_batch_id) {
+                my_batch_place[place] = my_batch_id;
+                my_conflicts.push_back(place);
+            }
+        }
+        for (int i = my_net->out_begin(t); i < my_net->out_end(t); ++i) {
+            int place = my_net->out_arc(i).place;
+            if (my_batch_place[place] != my_batch_id) {
+                my_batch_place[place] = my_batch_id;
+                my_conflicts.push_back(place);
+            }
+        }
+    }
+    my_conflict_begin[my_net->transition_count()] = my_conflicts.size();
+
+    this->reset();
+}
+
+/**
+ * \brief Navrat simulacie do pociatocneho znackovania siete zadanej pri
+ * prepare(). Prelozena siet sa znovu nevytvara.
+ */
+void Simulation::reset() {
+    this->set_marking(my_net->initial_marking());
+}
+
+/**
+ * \brief Zaciatok simulacie zo zadaneho znackovania siete zadanej pri
+ * prepare(), napriklad pociatocneho znackovania so zmenenymi miestami.
+ * \param marking znackovanie, tokeny kazdeho miesta siete su aktivne
  */
-bool Simulation::prepare(const QString & xml) {
-    bool rv = my_list.from_xml(xml, true);
-    return rv;
+void Simulation::set_marking(const SimMarking & marking) {
+    Q_ASSERT(marking.size() == my_net->place_count());
+
+    my_marking = marking;
+
+    my_token_count = 0;
+    for (int p = 0; p < my_marking.size(); ++p)
+        my_token_count += my_marking[p].active.size();
+
+    my_filled.clear();
+    my_filled_epoch.fill(0, my_marking.size());
+    my_touched_gen.fill(0, my_marking.size());
+
+    // V prvom kroku sa simuluju vsetky prechody.
+    int tcount = my_net->transition_count();
+    my_epoch = 1;
+    my_generation = 0;
+    my_queue.clear();
+    my_pending.resize(tcount);
+    my_marked.fill(my_epoch, tcount);
+    my_fired_gen.fill(0, tcount);
+    for (int t = 0; t < tcount; ++t)
+        my_pending[t] = t;
 }
 
 /**
- * \brief Prevedenie uplnej simulacie petriho siete.
- * \param result vysledna simulacia v XML formate
+ * \brief Povolenie simulacie nezavislych prechodov vo vlaknach. Volat pred
+ * prepare(), ktore pri povoleni vytvori konfliktne mnoziny prechodov.
+ * \param parallel false ak sa ma simulovat len vo volajucom vlakne
+ */
+void Simulation::set_parallel(bool parallel) {
+    my_batch_max = parallel && QThread::idealThreadCount() > 1
+                   ? SIMULATION_BATCH_MAX : 0;
+}
+
+/**
+ * \brief Nastavenie interpretu pre neprelozene vyrazy. Simulacia otvorena na
+ * serveri moze byt v kazdom poziadavku vybavovana inym vlaknom, programy
+ * predchadzajuceho interpretu musia byt uvolnene (release_scripts()).
+ * \param engine interpret vlakna, ktore simulaciu prave vybavuje
+ */
+void Simulation::set_engine(QScriptEngine * engine) {
+    my_engine = engine;
+}
+
+/**
+ * \brief Uvolnenie programov neprelozenych vyrazov. QScriptProgram sa pri
+ * prvom vyhodnoteni zaregistruje v interprete vlakna, preto nesmie prezit
+ * poziadavok, po ktorom simulaciu moze vybavovat alebo uvolnit ine vlakno.
+ * Volat vo vlakne, ktore simulaciu prave vybavuje.
+ */
+void Simulation::release_scripts() {
+    my_conditions.fill(QScriptProgram());
+    my_modes.fill(QScriptProgram());
+}
+
+/**
+ * \brief Prevedenie uplnej simulacie petriho siete. Vysledne znackovanie je
+ * mozne spristupnit pomocou marking(), zmeny pomocou changed() a fired().
  * \return false pre indikaciu chyby pri simulacii
  */
-bool Simulation::run(QString & result) {
-    return this->simulate(result, RUN);
+bool Simulation::run() {
+    return this->simulate(RUN);
 }
 
 /**
@@ -69,303 +224,910 @@ const QString & Simulation::error() const {
 }
 
 /**
- * \brief Prevedenie kroku simulacie petriho siete.
- * \param result vysledna simulacia v XML formate
+ * \brief Spristupnenie popisu limitu, ktorym bola simulacia ukoncena. Vysledok
+ * simulacie je v tom pripade ciastocny.
+ * \return popis limitu, prazdny ak simulacia skoncila sama
+ */
+const QString & Simulation::limit() const {
+    return my_limit;
+}
+
+/**
+ * \brief Nastavenie limitov simulacie.
+ * \param budget limity simulacie
+ */
+void Simulation::set_budget(const SimBudget & budget) {
+    my_budget = budget;
+}
+
+/**
+ * \brief Predvolene limity simulacie.
+ * \return limity simulacie
+ */
+SimBudget Simulation::default_budget() {
+    SimBudget budget;
+    budget.steps = SIMULATION_LOOP_COUNT;
+    budget.time = SIMULATION_TIME;
+    budget.tokens = SIMULATION_TOKENS;
+    return budget;
+}
+
+/**
+ * \brief Obmedzenie limitu z poziadavku limitom serveru.
+ * \param server limit serveru, 0 pre neobmedzeny
+ * \param request limit z poziadavku, 0 ak nebol zadany
+ * \return vysledny limit
+ */
+static unsigned sim_limit(unsigned server, unsigned request) {
+    if (request == 0)
+        return server;
+    if (server == 0)
+        return request;
+    return qMin(server, request);
+}
+
+/**
+ * \brief Limity simulacie pre poziadavok - limity z poziadavku, ktore
+ * neprekracuju limity serveru.
+ * \param server limity serveru
+ * \param request limity z poziadavku, 0 pre nezadany limit
+ * \return vysledne limity
+ */
+SimBudget Simulation::budget(const SimBudget & server,
+                             const SimBudget & request) {
+    SimBudget budget;
+    budget.steps = sim_limit(server.steps, request.steps);
+    budget.time = sim_limit(server.time, request.time);
+    budget.tokens = sim_limit(server.tokens, request.tokens);
+    return budget;
+}
+
+/**
+ * \brief Odsimulovanie jednej simulacie suboru. Kazda simulacia ma vlastny
+ * objekt Simulation, prelozena siet je zdielana.
+ */
+struct SimRunner {
+    SimNetPtr net;
+    SimBudget budget;
+    QScriptEngine * engine;     //!< 0 pri simulacii vo vlaknach QThreadPool.
+
+    void operator()(SimRun & run) const {
+        Simulation sim(engine);
+
+        // Simulacie suboru uz bezia vo vlaknach, prechody sa nedelia.
+        sim.set_parallel(engine != 0);
+        sim.set_budget(budget);
+        sim.prepare(net);
+        sim.set_marking(run.marking);
+
+        if (sim.run()) {
+            run.marking = sim.marking();
+            run.limit = sim.limit();
+        } else {
+            run.error = sim.error();
+        }
+    }
+};
+
+/**
+ * \brief Odsimulovanie suboru simulacii jednej siete z roznych pociatocnych
+ * znackovani. Siet s prelozenymi prechodmi sa simuluje vo vlaknach
+ * QThreadPool, inak postupne vo volajucom vlakne s jeho interpretom.
+ * \param net prelozena siet
+ * \param budget limity kazdej simulacie
+ * \param runs simulacie s pociatocnym znackovanim, doplni sa vysledok
+ * \param engine interpret volajuceho vlakna pre neprelozene vyrazy
+ */
+void Simulation::batch_run(const SimNetPtr & net, const SimBudget & budget,
+                           QVector<SimRun> & runs, QScriptEngine * engine) {
+    SimRunner runner;
+
+    runner.net = net;
+    runner.budget = budget;
+
+    if (net->compiled()) {
+        runner.engine = 0;
+        QtConcurrent::blockingMap(runs, runner);
+        return;
+    }
+
+    runner.engine = engine;
+    for (int i = 0; i < runs.size(); ++i)
+        runner(runs[i]);
+}
+
+/**
+ * \brief Prevedenie kroku simulacie petriho siete. Vysledne znackovanie je mozne
+ * spristupnit pomocou marking(), zmeny pomocou changed() a fired().
  * \return false pre indikaciu chyby pri simulacii
  */
-bool Simulation::step(QString & result) {
-    return this->simulate(result, STEP);
+bool Simulation::step() {
+    return this->simulate(STEP);
+}
+
+/**
+ * \brief Nasledne znackovania prechodu zo zadaneho znackovania pre analyzu
+ * stavoveho priestoru - jedno pre kazde viazanie tokenov, pri ktorom je
+ * prechod uskutocnitelny. Viazania, ktore sa lisia len tokenmi s rovnakou
+ * hodnotou, su jedno viazanie. Vystupne tokeny su v naslednom znackovani hned
+ * aktivne. Zaznamy simulacie (changed(), fired()) sa nemenia, limit casu plati
+ * od prveho volania.
+ * \param marking znackovanie siete zadanej pri prepare()
+ * \param trans index prechodu
+ * \param next nasledne znackovania, prazdne ak prechod nie je uskutocnitelny
+ * \return false ak nastala chyba alebo bol vycerpany limit, je potrebne overit
+ * error() a limit()
+ */
+bool Simulation::successors(const SimMarking & marking, int trans,
+                            QList<SimMarking> & next) {
+    if (! my_timer.isValid())
+        my_timer.start();
+
+    next.clear();
+    my_marking = marking;
+    my_firing.successors = &next;
+    this->transition_sim(my_firing, trans);
+    my_firing.successors = 0;
+
+    return my_error.isEmpty() && my_limit.isEmpty();
+}
+
+/**
+ * \brief Spristupnenie simulovanej siete.
+ * \return siet
+ */
+const SimNet & Simulation::net() const {
+    return *my_net;
+}
+
+/**
+ * \brief Spristupnenie aktualneho znackovania siete.
+ * \return tokeny miest podla indexu miesta
+ */
+const SimMarking & Simulation::marking() const {
+    return my_marking;
+}
+
+/**
+ * \brief Miesta, ktorych tokeny (ako multimnozina) sa zmenili poslednym
+ * krokom alebo odsimulovanim.
+ * \return indexy miest vzostupne
+ */
+const QVector<int> & Simulation::changed() const {
+    return my_changed;
+}
+
+/**
+ * \brief Prechody, ktore boli uspesne pri poslednom kroku alebo odsimulovani.
+ * \return indexy prechodov v poradi prveho uspechu
+ */
+const QVector<int> & Simulation::fired() const {
+    return my_fired;
 }
 
 /**
  * \brief Inicializuje strukturu pre simulaciu pre dany prechod.
+ * \param f stav simulacie prechodu
  * \param trans prechod pre ktory maju byt vytvorene struktuty
- * \param places_to miesta do ktorych sa budu tokeny presuvat
- * \param places_from miesta z ktorych sa budu tokeny presuvat
- */
-bool Simulation::init_places(Transition * trans, QVector<SimPart*> * places_to,
-                             QVector<SimPart*> * places_from) {
-    foreach (Arrow * arr, trans->arrows()) {
-        SimPart * sp = new SimPart;
-        sp->index = 0;
-        sp->name = arr->name();
-
-        if (dynamic_cast<Transition *>(arr->start_pnobject()) == trans) {
-            sp->place = dynamic_cast<Place*>(arr->end_pnobject());
-            places_to->push_back(sp);
-        } else if (dynamic_cast<Transition *>(arr->end_pnobject()) == trans) {
-            sp->place = dynamic_cast<Place*>(arr->start_pnobject());
-            places_from->push_back(sp);
-        } else {
-            debug("Error in arrow placement");
-            return false;
-        }
+ */
+void Simulation::init_places(SimFiring & f, int trans) {
+    SimPart sp;
+    sp.index = 0;
+
+    f.trans = trans;
+    f.from.clear();
+    f.to.clear();
+
+    for (int i = my_net->in_begin(trans); i < my_net->in_end(trans); ++i) {
+        sp.place = my_net->in_arc(i).place;
+        sp.name = my_net->in_arc(i).name;
+        f.from.push_back(sp);
     }
 
-    return true;
+    for (int i = my_net->out_begin(trans); i < my_net->out_end(trans); ++i) {
+        sp.place = my_net->out_arc(i).place;
+        sp.name = my_net->out_arc(i).name;
+        f.to.push_back(sp);
+    }
 }
 
 /**
- * \brief Dealokacia struktury pre simulaciu.
- * \param struktura simulacie
+ * \brief Predikat pre zistenie, ci su tokeny slotu uz viazane na predchadzajuce
+ * vstupne sipky z rovnakeho miesta.
+ * \param f stav simulacie prechodu
+ * \param level index vstupnej sipky
+ * \param index index slotu v mieste sipky
+ * \return true ak token zo slotu nie je mozne viazat
  */
-void Simulation::delete_places(QVector<SimPart*> * places) {
-    for (QVector<SimPart*>::iterator it = places->begin();
-            it != places->end();) {
-        delete *it;
-        it = places->erase(it);
+bool Simulation::used(const SimFiring & f, int level, int index) const {
+    int bound = 0;
+
+    for (int i = 0; i < level; ++i) {
+        if (f.from[i].place == f.from[level].place
+                && f.from[i].index == index)
+            ++bound;
     }
+    return bound >= my_marking[f.from[level].place].active.count(index);
+}
+
+/**
+ * \brief Overenie limitov pocas viazania tokenov. Prechod simulovany mimo
+ * hlavneho vlakna overuje len cas a vycerpanie si poznaci, limit nastavi
+ * hlavne vlakno.
+ * \param f stav simulacie prechodu
+ * \return true ak bol niektory z limitov prekroceny
+ */
+bool Simulation::expired(SimFiring & f) {
+    if (! f.parallel)
+        return this->exhausted();
+
+    if (my_budget.time != 0 && my_timer.elapsed() > my_budget.time)
+        f.timeout = true;
+    return f.timeout;
 }
 
 /**
- * \brief V rekurzii inkrementuje index na tokeny miesta danym indexom idx.
- * Pokial index na tokeny prekroci pocet indexovanych tokenov, index sa zmaze a
- * pokusi sa inkrementovat predchadzajuci index, ak sa nepodari, vracia false.
- * \param idx index miesta, ktoreho index sa ma inkrementovat
- * \param places vektor miest, ktorych sa indexy maju inkrementovat
- * \return false v pripade, ze nie je mozne vytvorit novu permutaciu - nie je
- * mozne inkrementovat  indexovane miesto ani miesta pred
+ * \brief Viazanie tokenov na vstupne sipky prechodu od sipky level. Tokeny su
+ * skusane postupne podla indexu, pre kazdu sipku sa skusi kazda hodnota len raz
+ * (tokeny s rovnakou hodnotou vedu k rovnakemu vysledku). Operandy prelozenej
+ * podmienky sa vyhodnotia hned po naviazani vsetkych ich premennych, takze sa
+ * neuspesne viazanie neprehlbuje.
+ * \param f stav simulacie prechodu
+ * \param level index vstupnej sipky, ktora sa ma viazat
+ * \return true ak bolo najdene viazanie a prechod bol uskutocneny
  */
-bool Simulation::transition_sim_inc(int idx, QVector<SimPart *> * places) {
-    Q_ASSERT(places);
+bool Simulation::bind(SimFiring & f, int level) {
+    if (level == f.from.size()) {
+        if (! f.successors)
+            return this->fire(f);
 
-    if (idx < 0) {
-        // Podtiekol index v rekurzii.
+        // Pri hladani vsetkych viazani sa prechod neuskutocni, viazanie
+        // pokracuje dalsimi tokenmi.
+        if (this->fire(f))
+            this->successor(f);
         return false;
-    } else if (places->at(idx)->index
-            >= places->at(idx)->place->active_tokens()->size()) {
-        // Pretiekol index, nastav aktualny na nula a skus inkrementovat
-        // predchadzajuci.
-        places->at(idx)->index = 0;
-        return transition_sim_inc(idx - 1, places);
-    } else {
-        // Aktualny index je v poriadku, zvys ho pre zistenie dalsej permutacie.
-        places->at(idx)->index++;
-        return true;
     }
+
+    const SimNet::SimTransition & t = my_net->transition(f.trans);
+    SimPart & part = f.from[level];
+    const TokenStore & tokens = my_marking[part.place].active;
+    int other;
+    double value;
+
+    if (t.compiled && t.condition_expr.key(level, other, value)) {
+        // Podmienka urcuje hodnotu tokenu, vyhladaj ho pomocou indexu miesta.
+        if (other >= 0)
+            value = f.slots[other];
+        if (value < INT_MIN || value > INT_MAX || value != std::floor(value))
+            return false;
+
+        if (tokens.counted()) {
+            // Slot pocitanych tokenov je priamo hodnota.
+            int idx = tokens.find(static_cast<int>(value));
+            if (idx < 0 || this->used(f, level, idx))
+                return false;
+
+            part.index = idx;
+            f.slots[level] = value;
+            return t.condition_expr.check(level, f.slots.data())
+                   && this->bind(f, level + 1);
+        }
+
+        if (! f.indexed[level]) {
+            f.index[level].clear();
+            for (int i = 0; i < tokens.slot_count(); ++i)
+                f.index[level][tokens.value(i)].push_back(i);
+            f.indexed[level] = true;
+        }
+
+        QHash<int, QVector<int> >::const_iterator it
+            = f.index[level].constFind(static_cast<int>(value));
+        if (it == f.index[level].constEnd())
+            return false;
+
+        // Vsetky najdene tokeny maju rovnaku hodnotu, staci prvy volny.
+        foreach (int idx, it.value()) {
+            if (this->used(f, level, idx))
+                continue;
+
+            part.index = idx;
+            f.slots[level] = value;
+            return t.condition_expr.check(level, f.slots.data())
+                   && this->bind(f, level + 1);
+        }
+        return false;
+    }
+
+    QSet<int> tried;
+    for (int i = 0; i < tokens.slot_count() && my_error.isEmpty(); ++i) {
+        if (this->used(f, level, i))
+            continue;
+
+        // Prechod s mnozstvom tokenov nesmie prekrocit cas simulacie.
+        if ((++f.probes & SIMULATION_PROBE_MASK) == 0 && this->expired(f))
+            return false;
+
+        if (! tokens.counted() && tokens.slot_count() > 1) {
+            if (tried.contains(tokens.value(i)))
+                continue;
+            tried.insert(tokens.value(i));
+        }
+
+        part.index = i;
+        if (t.compiled) {
+            f.slots[level] = tokens.value(i);
+            if (! t.condition_expr.check(level, f.slots.data()))
+                continue;
+        }
+
+        if (this->bind(f, level + 1))
+            return true;
+    }
+
+    return false;
 }
 
 /**
- * \brief Vykona jednu simulaciu nad jednym prechodom s ohladom na permutacie
- * indexov na miesta a ich tokeny.
- * \param idx index na miesto, ktoreho index na tokeny sa bude zvysovat
- * \param places miesta pre simulaciu
- * \param first_run true v pripade, ze ide o prvu permutaciu (index sa nezvysi)
+ * \brief Vyhodnotenie prechodu pre naviazane tokeny - overenie podmienky (ak
+ * nie je prelozena), vykonanie modu a pridanie pasivnych tokenov.
+ * \param f stav simulacie prechodu
+ * \return true ak mod priradil hodnotu aspon jednej vystupnej sipke
  */
-bool Simulation::transition_sim_step(int & idx, QVector<SimPart*> * places,
-                                    bool first_run) {
-    Q_ASSERT(places);
+bool Simulation::fire(SimFiring & f) {
+    const SimNet::SimTransition & t = my_net->transition(f.trans);
+    bool fired = false;
+
+    if (t.compiled) {
+        // Podmienka bola overena pocas viazania, vykonaj prelozeny mod
+        // prechodu. Hodnoty vystupnych sipok su v slotoch za vstupnymi.
+        t.mode_expr.mode(f.slots.data());
+
+        for (int i = f.to.size() - 1; i >= 0; --i) {
+            if (! t.mode_expr.assigned(i))
+                continue;
+
+            this->produce(f, f.to[i].place,
+                          Expr::to_token(f.slots[f.from.size() + i]));
+            fired = true;
+        }
+        return fired;
+    }
 
-    if (idx >= places->size()) {
-        // Nie je dostatok miest pre uskutocnenie prechodu.
+    for (int i = f.from.size() - 1; i >= 0; --i) {
+        // Nastav premenne, ktore reprezentuju jednotlive miesta.
+        const SimPart & sp = f.from[i];
+        my_scope.setProperty(sp.name,
+                             my_marking[sp.place].active.value(sp.index));
+    }
+
+    bool eval_rv = my_engine->evaluate(my_conditions[f.trans]).toBool();
+    // Osetrenie chyby.
+    if (my_engine->hasUncaughtException()) {
+        my_error = SIM_SYN_ERROR + t.name;
         return false;
     }
 
-    if (first_run
-            && places->at(idx)->index
-                <  places->at(idx)->place->active_tokens()->size()) {
-        return true;
+    if (! eval_rv)
+        return false;
+
+    // Nastav premenne na undefined, aby bolo mozne otestovat, ci sa vo
+    // vyraze dane miesto vobec nachadza.
+    for (int i = f.to.size() - 1; i >= 0; --i)
+        my_scope.setProperty(f.to[i].name, my_engine->undefinedValue());
+
+    // Vykonaj mod prechodu.
+    my_engine->evaluate(my_modes[f.trans]);
+
+    // Osetrenie chyby.
+    if (my_engine->hasUncaughtException()) {
+        my_error = SIM_SYN_ERROR + t.name;
+        return false;
+    }
+
+    // Pridaj pasivne tokeny do zadaneho miesta, ak sa vyskytuje hodnota
+    // pasivneho tokenu.
+    for (int i = f.to.size() - 1; i >= 0; --i) {
+        QScriptValue val = my_scope.property(f.to[i].name);
+        if (val.isUndefined())
+            continue;
+
+        this->produce(f, f.to[i].place, val.toInteger());
+        fired = true;
+    }
+
+    return fired;
+}
+
+/**
+ * \brief Prevedenie simulacie nad jednym prechodom. Menia sa len tokeny miest
+ * prechodu, zaznamy simulacie doplni commit().
+ * \param f stav simulacie prechodu
+ * \param trans index prechodu nad ktorym sa ma simulacia previest
+ * \return true ak bol prechod uskutocneny
+ */
+bool Simulation::transition_sim(SimFiring & f, int trans) {
+    const SimNet::SimTransition & t = my_net->transition(trans);
+    QScriptValue global;
+    bool fired;
+
+    this->init_places(f, trans);
+    f.produced = 0;
+    f.output.clear();
+
+    // Prechod bez vstupnych miest alebo s prazdnym vstupnym miestom nie je
+    // mozne uskutocnit.
+    if (f.from.isEmpty())
+        return false;
+    for (int i = 0; i < f.from.size(); ++i) {
+        if (my_marking[f.from[i].place].active.empty())
+            return false;
     }
 
-    if (places->at(idx)->index + 1
-            >= places->at(idx)->place->active_tokens()->size()) {
-        // Je prekroceny index pre indexovanie tokenov, je nutne inkrementovat
-        // predchadzajuci pre pokracovanie.
-        bool rv = transition_sim_inc(idx - 1, places);
-        if (! rv && idx == places->size() - 1) {
-            // Uz nie je mozne inkrementovat ziadne predchadzajuce indexy a nie
-            // je mozne pokracovat dalsim indexom na miesto -> koniec simulacie
-            // prechodu.
+    if (t.compiled) {
+        // Mod, ktory nepriradi hodnotu ziadnej vystupnej sipke, nepresunie
+        // ziadne tokeny.
+        bool assigns = false;
+        for (int i = 0; i < f.to.size(); ++i)
+            assigns = assigns || t.mode_expr.assigned(i);
+        if (! assigns)
             return false;
-        }
 
-        // Boli inkrementovane / znulovane predchadzajuce, nastav aktualny na
-        // nula a pokracuj dalsim indexom.
-        places->at(idx)->index = 0;
-        if (! rv)
-            ++idx;
-        return true;
+        f.slots.resize(t.mode_expr.slot_count());
+        if (! t.condition_expr.check(-1, f.slots.data()))
+            return false;
     } else {
-        // Inkrementuj index, pokial nejde o prvu permutaciu. (chybali by tie,
-        // ktore zacinaju 0).
-        places->at(idx)->index++;
-        return true;
+        if (my_conditions[trans].isNull()) {
+            my_conditions[trans] = QScriptProgram(t.condition, t.name);
+            my_modes[trans] = QScriptProgram(t.mode, t.name);
+        }
+
+        // Premenne prechodu su v novom globalnom objekte, ktoreho prototyp je
+        // povodny globalny objekt interpretu. Po simulacii prechodu sa povodny
+        // objekt obnovi, takze premenne neostanu v interprete.
+        global = my_engine->globalObject();
+        my_scope = my_engine->newObject();
+        my_scope.setPrototype(global);
+        my_engine->setGlobalObject(my_scope);
+    }
+
+    f.indexed.fill(false, f.from.size());
+    if (f.index.size() < f.from.size())
+        f.index.resize(f.from.size());
+
+    fired = this->bind(f, 0)
+            && (f.parallel ? ! f.timeout : my_limit.isEmpty());
+
+    if (! t.compiled) {
+        my_engine->clearExceptions();
+        my_engine->setGlobalObject(global);
+        my_scope = QScriptValue();
     }
+
+    if (fired && my_error.isEmpty() && ! f.parallel)
+        this->consume(f);
+
+    return fired && my_error.isEmpty();
+}
+
+/**
+ * \brief Odobratie viazanych tokenov uskutocneneho prechodu, pri simulacii vo
+ * vlakne aj pridanie jeho pasivnych tokenov.
+ * \param f stav simulacie uskutocneneho prechodu
+ */
+void Simulation::consume(const SimFiring & f) {
+    Simulation::take_bound(f, my_marking);
+
+    for (int i = 0; i < f.output.size(); ++i)
+        my_marking[f.output[i].first].passive.push_back(f.output[i].second);
 }
 
 /**
- * \brief Prevedenie simulacie nad jednym prechodom.
- * \param trans prechod nad ktorym sa ma simulacia previest
+ * \brief Odobratie viazanych tokenov prechodu zo znackovania.
+ * \param f stav simulacie prechodu s naviazanymi tokenmi
+ * \param marking znackovanie, z ktoreho boli tokeny viazane
  */
-bool Simulation::transition_sim(Transition * trans) {
-    Q_ASSERT(trans);
+void Simulation::take_bound(const SimFiring & f, SimMarking & marking) {
+    // Sloty jedneho miesta sa odoberaju od najvyssieho, odobratie presuva len
+    // sloty s vyssim indexom.
+    QVector<QPair<int, int> > bound;
+    for (int i = 0; i < f.from.size(); ++i)
+        bound.push_back(qMakePair(f.from[i].index, f.from[i].place));
+    qSort(bound.begin(), bound.end(), qGreater<QPair<int, int> >());
 
-    QScriptEngine * engine = new QScriptEngine;
-    bool eval_rv;
+    for (int i = 0; i < bound.size(); ++i)
+        marking[bound[i].second].active.take(bound[i].first);
+}
 
-    QVector<SimPart*> * places_to = new QVector<SimPart*>;
-    QVector<SimPart*> * places_from = new QVector<SimPart*>;
+/**
+ * \brief Zaznamenanie nasledneho znackovania pre naviazane tokeny, po ktorom
+ * sa pasivne tokeny prechodu odoberu. Znackovanie simulacie sa inak nemeni,
+ * vyssie urovne viazania maju odkazy na jeho tokeny.
+ * \param f stav simulacie prechodu, ktoreho mod bol prave vykonany
+ */
+void Simulation::successor(SimFiring & f) {
+    QVector<QPair<int, QVector<int> > > produced;
+
+    for (int i = 0; i < f.to.size(); ++i) {
+        QVector<int> & passive = my_marking[f.to[i].place].passive;
+        if (passive.isEmpty())
+            continue;
+        produced.push_back(qMakePair(f.to[i].place, passive));
+        passive.clear();
+    }
 
-    init_places(trans, places_to, places_from);
+    // Kopia sa oddeli hned, my_marking si tak ponecha svoje data.
+    SimMarking next = my_marking;
+    next.detach();
 
-    int idx = 0;
-    bool first_run = true;
-    bool fired = false; // Informacia o tom, ci boli rokeny presunute z miesta.
-    while (transition_sim_step(idx, places_from, first_run)
-            && my_error.isEmpty() && ! fired) {
-        fired = false; // Neboli presunute ziadne tokeny v aktualnom cykle.
-        first_run = false;
+    Simulation::take_bound(f, next);
+    for (int i = 0; i < produced.size(); ++i)
+        next[produced[i].first].active.add(produced[i].second);
 
-        for (int i = places_from->size() - 1; i >= 0; --i) {
-            // Nastav premenne, ktore reprezentuju jednotlive miesta, aktualne
-            // hodnoty ber podla indexov vypocitanych v transition_sim_step().
-            SimPart * sp = places_from->at(i);
-            if (sp->place->active_tokens()->size() == 0) {
-                engine->globalObject().setProperty(sp->name, 0);
-            } else {
-                engine->globalObject().setProperty(sp->name,
-                        sp->place->active_tokens()->at(sp->index));
-            }
+    f.successors->push_back(next);
+}
+
+/**
+ * \brief Simulacia jedneho prechodu v hlavnom vlakne. Pri vycerpani limitu sa
+ * prechod presunie do nasledujuceho kroku.
+ * \param trans index prechodu
+ * \param fired nastavi sa na true, ak bol prechod uskutocneny
+ * \return false pre indikaciu chyby pri simulacii
+ */
+bool Simulation::sequential(int trans, bool & fired) {
+    bool rv = this->transition_sim(my_firing, trans);
+
+    if (! rv && ! my_error.isEmpty())
+        return false;
+
+    if (rv) {
+        // Uspesny prechod sa simuluje aj v nasledujucom kroku.
+        this->commit(my_firing);
+        this->mark(trans);
+        fired = true;
+
+        if (my_fired_gen[trans] != my_generation) {
+            my_fired_gen[trans] = my_generation;
+            my_fired.push_back(trans);
         }
+    }
 
-        eval_rv = engine->evaluate(trans->condition()).toBool();
-        // Osetrenie chyby.
-        if (engine->hasUncaughtException()) {
-            my_error = SIM_SYN_ERROR + trans->name();
-            return false;
+    if (this->exhausted())
+        this->mark(trans);
+    return true;
+}
+
+/**
+ * \brief Simulacia prechodu davky vo vlakne z QThreadPool.
+ * \param f stav simulacie prechodu, prechod je v f.trans
+ */
+void Simulation::batch_sim(SimFiring & f) {
+    f.fired = f.sim->transition_sim(f, f.trans);
+}
+
+/**
+ * \brief Zaznamenanie uskutocneneho prechodu - miesta prechodu su kandidati na
+ * zmenu tokenov, vystupne miesta maju pasivne tokeny.
+ * \param f stav simulacie uskutocneneho prechodu
+ */
+void Simulation::commit(const SimFiring & f) {
+    for (int i = 0; i < f.from.size(); ++i)
+        this->record(f.from[i].place);
+    for (int i = 0; i < f.to.size(); ++i) {
+        int place = f.to[i].place;
+
+        this->record(place);
+        if (my_filled_epoch[place] != my_epoch) {
+            my_filled_epoch[place] = my_epoch;
+            my_filled.push_back(place);
         }
+    }
 
-        // Vykonaj podmienku prechodu, ak je true, tak je mozne tokeny presunut.
-        if (eval_rv) {
-            // Nastav premenne na undefined, aby bolo mozne otestovat, ci sa vo
-            // vyraze dane miesto vobec nachadza.
-            for (int i = places_to->size() - 1; i >= 0; --i) {
-                engine->globalObject().setProperty(places_to->at(i)->name,
-                                               engine->undefinedValue());
-            }
+    my_token_count += f.produced;
+    my_token_count -= f.from.size();
+}
+
+/**
+ * \brief Pridanie pasivneho tokenu do miesta. Miesto zaradi medzi miesta,
+ * ktorych pasivne tokeny sa na konci kroku presunu medzi aktivne, az commit().
+ * Pri simulacii vo vlakne sa token len zaznamena, do miesta ho prida consume().
+ * \param f stav simulacie prechodu
+ * \param place index miesta
+ * \param token hodnota tokenu
+ */
+void Simulation::produce(SimFiring & f, int place, int token) {
+    if (f.parallel)
+        f.output.push_back(qMakePair(place, token));
+    else
+        my_marking[place].passive.push_back(token);
+    f.produced++;
+}
 
-            // Vykonaj mod prechodu.
-            engine->evaluate(trans->mode());
+/**
+ * \brief Vyber prechodov z haldy aktualneho kroku, ktore je mozne simulovat
+ * naraz. Prechody davky su prelozene a nemaju spolocne vstupne ani vystupne
+ * miesto, navzajom si teda nemenia tokeny a vysledok je rovnaky ako pri
+ * simulacii v poradi priority. Davka sa uzavrie prvym prechodom, ktory do nej
+ * nepatri - ten zostane v halde.
+ * \return pocet prechodov v davke
+ */
+int Simulation::collect() {
+    int count = 0;
+    unsigned tokens = my_token_count;
 
-            // Osetrenie chyby.
-            if (engine->hasUncaughtException()) {
-                my_error = SIM_SYN_ERROR + trans->name();
-                return false;
-            }
+    ++my_batch_id;
+    while (! my_queue.isEmpty() && count < my_batch_max) {
+        int trans = my_net->ranked(my_queue.front());
+        if (! my_net->transition(trans).compiled)
+            break;
+
+        // Davka nesmie prekrocit limit tokenov ani pri uspechu vsetkych
+        // prechodov, inak by sa vysledok lisil od simulacie v poradi.
+        tokens += my_net->out_end(trans) - my_net->out_begin(trans);
+        if (my_budget.tokens != 0 && tokens > my_budget.tokens)
+            break;
 
-            // Pridaj pasivne tokeny do zadaneho miesta, ak sa vyskytuje hodnota
-            // pasivneho tokenu.
-            for (int i = places_to->size() - 1; i >= 0; --i) {
-                QScriptValue val = engine->globalObject()
-                                    .property(places_to->at(i)->name);
-                if (val.isUndefined())
-                    continue;
+        int begin = my_conflict_begin[trans];
+        int end = my_conflict_begin[trans + 1];
+        int i;
+        for (i = begin; i < end; ++i) {
+            if (my_batch_place[my_conflicts[i]] == my_batch_id)
+                break;
+        }
+        if (i < end)
+            break;
+        for (i = begin; i < end; ++i)
+            my_batch_place[my_conflicts[i]] = my_batch_id;
 
-                places_to->at(i)->place->add_passive_token(val.toInteger());
+        std::pop_heap(my_queue.begin(), my_queue.end(), std::greater<int>());
+        my_queue.pop_back();
 
-                // Splnil sa aspon jeden prechod s tokenmi, takze sa musia
-                // odobrat z miesta from.
-                fired = true;
-            }
+        if (my_batch.size() <= count)
+            my_batch.resize(count + 1);
+        my_batch[count].sim = this;
+        my_batch[count].trans = trans;
+        my_batch[count].probes = 0;
+        my_batch[count].parallel = true;
+        my_batch[count].timeout = false;
+        my_batch[count].fired = false;
+        my_batch[count].successors = 0;
+        ++count;
+    }
+
+    return count;
+}
+
+/**
+ * \brief Simulacia davky prechodov vo vlaknach QThreadPool a zaznamenanie
+ * vysledkov v poradi priority.
+ * \param count pocet prechodov v davke
+ * \return true ak bol uskutocneny aspon jeden prechod
+ */
+bool Simulation::batch(int count) {
+    bool fired = false;
+    bool timeout = false;
+
+    // Znackovanie sa musi oddelit od my_before este pred vlaknami, inak by sa
+    // oddelovalo vo vsetkych naraz. Vlakna znackovanie len citaju.
+    my_marking.detach();
+
+    QtConcurrent::blockingMap(my_batch.begin(), my_batch.begin() + count,
+                              &Simulation::batch_sim);
+
+    for (int i = 0; i < count; ++i) {
+        const SimFiring & f = my_batch[i];
+
+        // Po vycerpani casu sa ako pri simulacii v poradi nasledujuce prechody
+        // presunu do dalsieho kroku, aj ked vo vlakne uspeli.
+        if (timeout) {
+            this->mark(f.trans);
+            continue;
         }
 
-        if (fired) {
-            // Odober tokeny, ktore boli pouzite.
-            for(int i = places_from->size() - 1; i >=0; --i) {
-                if (places_from->at(i)->index
-                        >= places_from->at(i)->place->active_tokens()->size())
-                    continue;
-                places_from->at(i)->place->active_tokens()
-                    ->remove(places_from->at(i)->index);
+        if (f.fired) {
+            this->consume(f);
+            this->commit(f);
+            this->mark(f.trans);
+            fired = true;
+            if (my_fired_gen[f.trans] != my_generation) {
+                my_fired_gen[f.trans] = my_generation;
+                my_fired.push_back(f.trans);
             }
+        } else if (f.timeout) {
+            // Prechod sa pre vycerpany cas nedosimuloval.
+            my_limit = SIM_LIMIT_TIME;
+            this->mark(f.trans);
+            timeout = true;
         }
     }
 
+    return fired;
+}
 
-    this->delete_places(places_to);
-    this->delete_places(places_from);
+/**
+ * \brief Zaradenie prechodu medzi prechody simulovane v nasledujucom kroku.
+ * Prechod je zaradeny, ak je jeho znacka rovna aktualnemu kroku - zaciatkom
+ * kroku sa tak vsetky znacky zrusia naraz.
+ * \param trans index prechodu
+ */
+void Simulation::mark(int trans) {
+    if (my_marked[trans] == my_epoch)
+        return;
 
-    delete places_to;
-    delete places_from;
+    my_marked[trans] = my_epoch;
+    my_pending.push_back(trans);
+}
 
-    engine->collectGarbage();
-    delete engine;
+/**
+ * \brief Oznamenie pridania aktivnych tokenov miesta na konci kroku. Prechody,
+ * pre ktore je miesto vstupom, sa simuluju v nasledujucom kroku.
+ * \param place index miesta
+ */
+void Simulation::touch(int place) {
+    for (int i = my_net->consumer_begin(place);
+            i < my_net->consumer_end(place); ++i)
+        this->mark(my_net->consumer(i));
+}
 
-    return fired;
+/**
+ * \brief Overenie limitov casu a poctu tokenov. Pri prekroceni limitu je
+ * nastaveny jeho popis, ktory je mozne spristupnit pomocou limit().
+ * \return true ak bol niektory z limitov prekroceny
+ */
+bool Simulation::exhausted() {
+    if (! my_limit.isEmpty())
+        return true;
+
+    if (my_budget.tokens != 0 && my_token_count > my_budget.tokens)
+        my_limit = SIM_LIMIT_TOKENS;
+    else if (my_budget.time != 0 && my_timer.elapsed() > my_budget.time)
+        my_limit = SIM_LIMIT_TIME;
+
+    return ! my_limit.isEmpty();
+}
+
+/**
+ * \brief Zaznamenanie miesta, ktoreho tokeny sa mohli zmenit.
+ * \param place index miesta
+ */
+void Simulation::record(int place) {
+    if (my_touched_gen[place] == my_generation)
+        return;
+
+    my_touched_gen[place] = my_generation;
+    my_touched.push_back(place);
+}
+
+/**
+ * \brief Vyber zaznamenanych miest, ktorych tokeny sa oproti znackovaniu pred
+ * simulaciou naozaj zmenili. Na poradi tokenov v mieste nezalezi.
+ */
+void Simulation::diff() {
+    QVector<int> before, after;
+
+    my_changed.clear();
+    qSort(my_touched.begin(), my_touched.end());
+    for (int i = 0; i < my_touched.size(); ++i) {
+        int p = my_touched[i];
+
+        before = my_before[p].active.values() + my_before[p].passive;
+        after = my_marking[p].active.values() + my_marking[p].passive;
+        qSort(before.begin(), before.end());
+        qSort(after.begin(), after.end());
+        if (before != after)
+            my_changed.push_back(p);
+    }
+
+    // Kopia zdiela nezmenene tokeny so znackovanim, uvolni sa hned.
+    my_before.clear();
 }
 
 /**
  * \brief Implementacia simulacie petriho siete.
- * \param result vysledok simulacie v XML
  * \param type typ simulacie (krok, odsimulovanie)
- * \return false pre indikaciu chyby pri simulacii (prekroceny limit)
+ * \return false pre indikaciu chyby pri simulacii, pri prekroceni limitu je
+ * vysledkom ciastocne odsimulovana siet
  */
-bool Simulation::simulate(QString & result, enum SimType type) {
-    Transition * t = 0;     // Pomocny ukazatel na prechod.
-    Transition * tsim = 0;  // Prechod, ktory bude simulovany.
-    Place * p;
-    bool rv;
-    unsigned count;
-    unsigned nop_count;   // Pocet prechodov u ktorych nedoslo k presunu tokenov.
+bool Simulation::simulate(enum SimType type) {
+    int tsim;               // Prechod, ktory bude simulovany.
+    unsigned count = 0;     // Pocet odsimulovanych krokov.
+    bool fired;             // V kroku bol uspesny aspon jeden prechod.
 
     my_error.clear();
+    my_limit.clear();
+    my_timer.start();
+    my_firing.probes = 0;
 
-    result.clear();
-
-    count = type == RUN ? SIMULATION_LOOP_COUNT : 1;
+    // Znackovanie je implicitne zdielane, kopiruju sa len menene miesta.
+    // Zaznamy predchadzajucej simulacie zrusi nova generacia.
+    my_before = my_marking;
+    ++my_generation;
+    my_touched.clear();
+    my_changed.clear();
+    my_fired.clear();
 
     do {
-        nop_count = 0;
-        for (unsigned i = my_list.transition_count(); i != 0; --i) {
-            t = 0;
-            tsim = 0;
-
-            // Vyber prechod s najvyssou prioritou.
-            for (PNList_iter it = my_list.begin(); it != my_list.end(); ++it) {
-                if ((t = dynamic_cast<Transition*>(*it))) {
-                    if ((! tsim && t->active())
-                            || (tsim && t->active()
-                                && tsim->priority() < t->priority())) {
-                        tsim = t;
-                    }
-                }
-            }
+        fired = false;
 
-            // Odsimulovanie a zneaktivnenie prechodu.
-            if (tsim) {
-                rv = transition_sim(tsim);
+        // Prechody, ktorych vstupne miesta sa zmenili, sa simuluju v poradi
+        // podla priority. Novy krok zrusi znacky zaradenych prechodov.
+        for (int i = 0; i < my_pending.size(); ++i)
+            my_queue.push_back(my_net->rank(my_pending[i]));
+        my_pending.clear();
+        ++my_epoch;
+        std::make_heap(my_queue.begin(), my_queue.end(), std::greater<int>());
 
-                if (! rv && ! my_error.isEmpty()) {
+        while (! my_queue.isEmpty()) {
+            // Nezavisle prelozene prechody sa simuluju naraz, ostatne v poradi
+            // priority po jednom.
+            int size = my_batch_max != 0 ? this->collect() : 0;
+
+            if (size >= SIMULATION_BATCH_MIN) {
+                fired = this->batch(size) || fired;
+                size = 0;
+            } else if (size == 0) {
+                std::pop_heap(my_queue.begin(), my_queue.end(),
+                              std::greater<int>());
+                if (my_batch.isEmpty())
+                    my_batch.resize(1);
+                my_batch[0].trans = my_net->ranked(my_queue.back());
+                my_queue.pop_back();
+                size = 1;
+            }
+
+            for (int i = 0; i < size; ++i) {
+                tsim = my_batch[i].trans;
+                if (! my_limit.isEmpty()) {
+                    this->mark(tsim);
+                } else if (! this->sequential(tsim, fired)) {
+                    // Zvysok davky sa vrati do haldy.
+                    for (++i; i < size; ++i) {
+                        my_queue.push_back(my_net->rank(my_batch[i].trans));
+                        std::push_heap(my_queue.begin(), my_queue.end(),
+                                       std::greater<int>());
+                    }
+                    my_before.clear();
                     return false; // Doslo k chybe pri simulacii.
-                } else if (! rv) {
-                    nop_count++; // V simulacii nebol token premiestneny.
                 }
+            }
 
-                tsim->set_active(false);
+            if (this->exhausted()) {
+                // Prechody, na ktore v kroku nedoslo, sa presunu do
+                // nasledujuceho kroku, aby bolo mozne v simulacii pokracovat.
+                while (! my_queue.isEmpty()) {
+                    tsim = my_net->ranked(my_queue.back());
+                    my_queue.pop_back();
+                    this->mark(tsim);
+                }
             }
         }
 
-        // Obnovenie siete a priprava pre dalsi beh simulacie.
-        for (PNList_iter it = my_list.begin(); it != my_list.end(); ++it) {
-            if ((p = dynamic_cast<Place *>(*it))) {
-                p->flush_tokens(); // Vsetky tokeny zarad medzi aktivne.
-            } else if ((t = dynamic_cast<Transition*>(*it))) {
-                t->set_active(true);
-            }
+        // Obnovenie siete a priprava pre dalsi beh simulacie - pasivne tokeny
+        // zarad medzi aktivne. Prechadzaju sa len miesta, do ktorych boli
+        // v kroku pridane tokeny.
+        for (int i = 0; i < my_filled.size(); ++i) {
+            int p = my_filled[i];
+            SimTokens & tokens = my_marking[p];
+            if (tokens.passive.isEmpty())
+                continue;
+
+            tokens.active.add(tokens.passive);
+            tokens.passive.clear();
+            this->touch(p);
         }
+        my_filled.clear();
+
+        ++count;
 
     // Simuluje sa kym sa neprekroci limit vyhradeny pre simulaciu alebo kym uz
-    // nie je co simulovat - pocet prechodov u ktorych nebol token presunuty, je
-    // rovny poctu celkovych prechodov.
-    } while (--count && nop_count != my_list.transition_count());
+    // nie je co simulovat - v kroku nebol uspesny ziadny prechod.
+    } while (type == RUN && fired && my_limit.isEmpty()
+             && (my_budget.steps == 0 || count < my_budget.steps));
 
-    // Bolo presiahnute maximalne mnozstvo iteracii pri plnej simulacii.
-    if (count == 0 && type == RUN) {
-        my_error = SIM_TIME_CYCLE;
-        return false;
-    }
+    // Bolo presiahnute maximalne mnozstvo krokov pri plnej simulacii, vysledkom
+    // je siet po poslednom kroku.
+    if (type == RUN && fired && my_limit.isEmpty())
+        my_limit = SIM_LIMIT_STEPS;
 
-    my_list.xml(result);
+    this->diff();
     return true;
 }
-
@@ -0,0 +1,205 @@
+/**
+ * \file     tokenstore.cpp
+ * \brief    Ulozenie aktivnych tokenov miesta pocas simulacie.
+ * \author   Fridolin Pokorny  <fridex.devel@gmail.com>
+ * \author   Miroslav Lisik    <xlisik00@stud.fit.vutbr.cz>
+ * \date     may 18 2012
+ */
+
+#include <QVector>
+#include <QHash>
+
+#include <pn/server/tokenstore.h>
+
+/**
+ * Pocet tokenov, od ktoreho sa zvazuje pocitanie rovnakych hodnot.
+ */
+const int TOKENSTORE_MIN = 64;
+
+/**
+ * \brief Konstruktor prazdneho miesta.
+ */
+TokenStore::TokenStore() {
+    my_size = 0;
+    my_check = TOKENSTORE_MIN;
+    my_counted = false;
+}
+
+/**
+ * \brief Pocet tokenov.
+ * \return pocet tokenov
+ */
+int TokenStore::size() const {
+    return my_size;
+}
+
+/**
+ * \brief Predikat pre prazdne miesto.
+ * \return true ak miesto nema ziadny token
+ */
+bool TokenStore::empty() const {
+    return my_size == 0;
+}
+
+/**
+ * \brief Pocet slotov - tokenov, pri pocitani roznych hodnot.
+ * \return pocet slotov
+ */
+int TokenStore::slot_count() const {
+    return my_values.size();
+}
+
+/**
+ * \brief Hodnota tokenu v slote.
+ * \param slot index slotu
+ * \return hodnota tokenu
+ */
+int TokenStore::value(int slot) const {
+    return my_values.at(slot);
+}
+
+/**
+ * \brief Pocet tokenov v slote.
+ * \param slot index slotu
+ * \return pocet tokenov, bez pocitania vzdy 1
+ */
+int TokenStore::count(int slot) const {
+    return my_counted ? my_counts.at(slot) : 1;
+}
+
+/**
+ * \brief Predikat pre ulozenie tokenov ako hodnot s poctom.
+ * \return true ak slot zodpoveda hodnote
+ */
+bool TokenStore::counted() const {
+    return my_counted;
+}
+
+/**
+ * \brief Vyhladanie slotu hodnoty, len pri pocitani.
+ * \param value hodnota tokenu
+ * \return index slotu, -1 ak token s hodnotou nie je v mieste
+ */
+int TokenStore::find(int value) const {
+    return my_slots.value(value, -1);
+}
+
+/**
+ * \brief Vsetky tokeny miesta v poradi slotov.
+ * \return hodnoty tokenov
+ */
+QVector<int> TokenStore::values() const {
+    if (! my_counted)
+        return my_values;
+
+    QVector<int> tokens;
+    tokens.reserve(my_size);
+    for (int i = 0; i < my_values.size(); ++i)
+        tokens.insert(tokens.end(), my_counts[i], my_values[i]);
+    return tokens;
+}
+
+/**
+ * \brief Pridanie tokenu.
+ * \param value hodnota tokenu
+ */
+void TokenStore::add(int value) {
+    ++my_size;
+
+    if (! my_counted) {
+        my_values.push_back(value);
+        if (my_size >= my_check)
+            this->count_tokens();
+        return;
+    }
+
+    QHash<int, int>::iterator it = my_slots.find(value);
+    if (it != my_slots.end()) {
+        my_counts[*it]++;
+        return;
+    }
+
+    my_slots.insert(value, my_values.size());
+    my_values.push_back(value);
+    my_counts.push_back(1);
+
+    // Hodnoty sa prestali opakovat, pole je mensie a rychlejsie.
+    if (my_values.size() * 2 > my_size)
+        this->spread_tokens();
+}
+
+/**
+ * \brief Pridanie tokenov.
+ * \param tokens hodnoty tokenov
+ */
+void TokenStore::add(const QVector<int> & tokens) {
+    foreach (int token, tokens)
+        this->add(token);
+}
+
+/**
+ * \brief Odobratie jedneho tokenu zo slotu. Posledny slot sa moze presunut na
+ * miesto odobrateho, sloty s vyssim indexom su preto neplatne.
+ * \param slot index slotu
+ */
+void TokenStore::take(int slot) {
+    int last = my_values.size() - 1;
+
+    --my_size;
+
+    if (my_counted) {
+        if (--my_counts[slot] > 0)
+            return;
+        my_slots.remove(my_values[slot]);
+        if (slot != last) {
+            my_counts[slot] = my_counts[last];
+            my_slots[my_values[last]] = slot;
+        }
+        my_counts.pop_back();
+    }
+
+    my_values[slot] = my_values[last];
+    my_values.pop_back();
+}
+
+/**
+ * \brief Volba ulozenia pri naraste poctu tokenov. Ak sa hodnoty casto
+ * opakuju, tokeny sa zacnu pocitat. Inak sa dalsia volba odlozi na dvojnasobny
+ * pocet tokenov, takze je v priemere O(1) na pridany token.
+ */
+void TokenStore::count_tokens() {
+    QHash<int, int> index;
+    QVector<int> values, counts;
+
+    foreach (int token, my_values) {
+        QHash<int, int>::iterator it = index.find(token);
+        if (it != index.end()) {
+            counts[*it]++;
+            continue;
+        }
+        index.insert(token, values.size());
+        values.push_back(token);
+        counts.push_back(1);
+    }
+
+    if (values.size() * 4 > my_size) {
+        my_check = my_size * 2;
+        return;
+    }
+
+    my_values = values;
+    my_counts = counts;
+    my_slots = index;
+    my_counted = true;
+}
+
+/**
+ * \brief Prevod pocitanych hodnot spat na pole tokenov.
+ */
+void TokenStore::spread_tokens() {
+    my_values = this->values();
+    my_counts.clear();
+    my_slots.clear();
+    my_counted = false;
+    my_check = my_size * 2;
+}